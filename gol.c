@@ -16,53 +16,823 @@
  */
 
 #define _XOPEN_SOURCE 600
+#define _GNU_SOURCE
 #define DELAY 100000
 #define MAXFILE 10000
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <sys/time.h>
+#include <time.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
+#include <poll.h>
 #include <errno.h>
 #include <semaphore.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// Number of cells packed into one word of a board row.
+#define WORD_BITS 64
+
+// The most rows or columns a board can have, well clear of overflowing
+// the int arithmetic on row and column indices.
+#define MAX_BOARD_SIDE (1 << 30)
+
+// The SSE2 and AVX2 kernels are written with GCC vector extensions and
+// compiled per function for the wider instruction set, so they are only
+// built on x86 and picked at run time based on what the CPU supports.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_SIMD 1
+typedef uint64_t vec2_u64 __attribute__((vector_size(16)));
+typedef uint64_t vec4_u64 __attribute__((vector_size(32)));
+#endif
+
+// An outer-totalistic rule in B/S notation: bit n of birth is set when a
+// dead cell with n live neighbors comes alive, and bit n of survive when a
+// live cell with n live neighbors stays alive. Conway's Life is B3/S23.
+typedef struct rule {
+	uint16_t birth;
+	uint16_t survive;
+} Rule;
 
 // Use a struct to save the initial conditions to minimize function
 // parameters.
 typedef struct init {
 	int num_rows;
 	int num_cols;
-	int iterations;
+	long long iterations;
 	int init_pairs;
+	Rule rule;
 } init_data;
 
+// A bit-packed game board. Each cell is a single bit (1 = alive, 0 = dead)
+// and every row is padded out to a whole number of 64-bit words, so no two
+// rows ever share a word and a zero-filled allocation is an empty board.
+//
+// The board is surrounded by a halo ring holding copies of the opposite
+// edges of the torus: rows -1 and num_rows, and columns -2, -1, num_cols and
+// num_cols + 1. Columns -2 and -1 are the top bits of an extra word in front
+// of each row and columns num_cols and num_cols + 1 are the first bits after
+// the last column (padding bits, or an extra word when num_cols is a multiple
+// of 64). row_pitch counts those extra words; cells points at word 0 of
+// row 0.
+typedef struct board {
+	int num_rows;
+	int num_cols;
+	int row_words;
+	int row_pitch;
+	uint64_t *base;
+	uint64_t *cells;
+} Board;
+
+// A byte-per-cell board (0 = dead, 1 = alive) with the same halo ring as
+// Board: row_pitch is num_cols + 2 and cells points at column 0 of row 0.
+// Used by the column-sum engine.
+typedef struct byte_board {
+	int num_rows;
+	int num_cols;
+	int row_pitch;
+	uint8_t *base;
+	uint8_t *cells;
+} ByteBoard;
+
+// The step kernels that can be selected with -e. SCALAR is the original
+// cell at a time neighbors() walk; WORD, SSE2 and AVX2 update 64, 128 or 256
+// cells at once on the bit-packed board; COLSUM keeps a byte-per-cell copy of
+// the board and slides three-row column sums across it; LUT and LUT2 look up
+// each 2x2 block's next one or two generations in a table built from the rule;
+// HASHLIFE runs on its own (not strip-threaded) and jumps 2^k generations;
+// SPARSE also runs on its own and only visits live cells and their neighbors.
+typedef enum engine {
+	ENGINE_SCALAR,
+	ENGINE_WORD,
+	ENGINE_SSE2,
+	ENGINE_AVX2,
+	ENGINE_COLSUM,
+	ENGINE_LUT,
+	ENGINE_LUT2,
+	ENGINE_HASHLIFE,
+	ENGINE_SPARSE,
+	NUM_ENGINES
+} Engine;
+
+// How the threads keep in step between generations, selected with -S.
+// PTHREAD has every thread meet at one pthread barrier; NEIGHBOR has each
+// thread wait only for the strips its next generation reads from. SPIN
+// and DISSEMINATION are barriers of our own that spin before sleeping:
+// SPIN has everyone count in at one place, DISSEMINATION has each thread
+// hear from log2(threads) others, so no cache line is shared by them all.
+// WAVEFRONT has no generations at all: any thread steps any band whose
+// neighbors have caught up with it.
+typedef enum sync_mode {
+	SYNC_PTHREAD,
+	SYNC_NEIGHBOR,
+	SYNC_SPIN,
+	SYNC_DISSEMINATION,
+	SYNC_WAVEFRONT,
+	NUM_SYNCS
+} SyncMode;
+
+// How many times a thread checks a neighbor's progress before going to
+// sleep on it.
+#define STRIP_SPINS 1000
+
+// A strip's progress under NEIGHBOR sync: the number of generations its
+// thread has finished, and how many threads are asleep waiting for it to
+// go up. Each one gets its own cache line.
+typedef struct strip_sync {
+	_Alignas(64) atomic_uint done;
+	atomic_int waiters;
+} StripSync;
+
+// How many times a thread checks a barrier before going to sleep on it.
+#define BARRIER_SPINS 1000
+
+// The SPIN barrier. The last thread to count in resets count and flips
+// sense, which the others spin on, then sleep on with a futex. The two
+// sit on their own cache lines, so spinners don't slow the count.
+typedef struct spin_barrier {
+	_Alignas(64) atomic_uint count;
+	_Alignas(64) atomic_uint sense;
+	atomic_int waiters;
+	unsigned int num_threads;
+} SpinBarrier;
+
+// A band under WAVEFRONT sync: the generation it has reached, and whether
+// a thread is stepping it right now.
+typedef struct wave_band {
+	_Alignas(64) atomic_llong generation;
+	atomic_int busy;
+} WaveBand;
+
+// What claimBand returns instead of a band.
+#define WAVE_NONE -1
+#define WAVE_DONE -2
+
+// The board under WAVEFRONT sync: num_bands bands of band_rows rows, each
+// at its own generation. Generation g of a band is in boards[g & 1].
+// progress counts the bands stepped, for threads with nothing to claim to
+// sleep on, and finished the bands that have reached the end.
+typedef struct wavefront {
+	int band_rows;
+	int num_bands;
+	Board *boards[2];
+	WaveBand *bands;
+	StripSync progress;
+	_Alignas(64) atomic_int finished;
+} Wavefront;
+
+// How many board snapshots the renderer holds; a power of two.
+#define RENDER_SLOTS 4
+
+// The verbose-mode renderer: a thread of its own that prints the boards
+// the simulation hands it through a single-producer, single-consumer ring,
+// so the simulation never waits on the terminal. pushed and popped count
+// the snapshots put in and printed, and are what each side sleeps on when
+// the ring is empty or full. A snapshot that finds the ring full is
+// dropped, unless it is the last one: that board is kept in last and
+// queued once the run has been timed.
+typedef struct renderer {
+	Board *frames[RENDER_SLOTS];
+	long long iterations[RENDER_SLOTS];
+	StripSync pushed;
+	StripSync popped;
+	const Board *last;
+	long long last_iteration;
+	int last_dropped;
+	long long dropped;
+	long long frames_seen;
+	pthread_t thread;
+} Renderer;
+
+// How rows are handed out to the threads, selected with -P. STATIC gives
+// each thread one fixed strip; STEAL cuts the board into bands that each
+// thread starts on its own share of and steals from the others once done.
+typedef enum partition {
+	PARTITION_STATIC,
+	PARTITION_STEAL,
+	NUM_PARTITIONS
+} Partition;
+
+// Everything the command line sets about how a board is run.
+typedef struct options {
+	int verbose;
+	int p_flag;
+	int num_threads;
+	Engine engine;
+	long hashlife_mb;
+	int tile_size;
+	int detect;
+	int time_block;
+	SyncMode sync_mode;
+	Partition partition;
+	char *affinity;
+	int rebalance;
+	long long iterations;
+} Options;
+
+// The values getopt_long returns for the options with no short form.
+#define OPT_AUTOTUNE 256
+#define OPT_RANKS 257
+#define OPT_RANK 258
+#define OPT_PEERS 259
+#define OPT_HALO 260
+#define OPT_BATCH 261
+#define OPT_UNIVERSES 262
+
+// Boards in a --batch with at most this many cells are run whole by one
+// worker each; bigger ones get every thread, one board at a time.
+#define BATCH_SMALL_CELLS (1 << 20)
+
+// One board of a --batch, and what became of it. usec counts only the
+// stepping, not the loading. error says why the board could not be
+// loaded, if it couldn't.
+typedef struct batch_job {
+	char *config_file;
+	init_data bounds;
+	Board *earth;
+	const char *error;
+	long long population;
+	uint64_t hash;
+	long long usec;
+} BatchJob;
+
+// The --batch worker pool's shared state: the jobs, the index of the next
+// one to hand out, and what every worker runs its boards with.
+typedef struct batch {
+	BatchJob *jobs;
+	int num_jobs;
+	atomic_int next_job;
+	Options options;
+	const Rule *rule;
+} Batch;
+
+// Up to MAX_UNIVERSES boards of one size, stepped together by --universes.
+// Bit u of a cell's words is the cell in universe u, so the word-parallel
+// adders advance every universe in one pass. Each cell takes lanes words
+// (64 universes apiece) and sits next to its row neighbors, with a halo
+// cell on either end of a row and a halo row above and below.
+#define MAX_UNIVERSES 256
+
+typedef struct universes {
+	int num_rows;
+	int num_cols;
+	int lanes;
+	int row_words;
+	uint64_t *base;
+} Universes;
+
+// One thread's rows of the --universes, row_start..row_end. Every thread
+// keeps its own pointers to the shared earth and next and swaps them after
+// each generation, once thread 0 has refreshed the halo.
+typedef struct universe_strip {
+	Universes *earth;
+	Universes *next;
+	int row_start;
+	int row_end;
+	int tid;
+	int print_thread;
+	long long iterations;
+	Engine engine;
+	Rule rule;
+	pthread_barrier_t *BARRIER;
+} UniverseStrip;
+
+// initEarth parses the cells of a config file on one thread per
+// PARSE_CHUNK_BYTES of it, up to one per CPU and PARSE_MAX_THREADS.
+#define PARSE_CHUNK_BYTES (1 << 20)
+#define PARSE_MAX_THREADS 64
+
+// One thread's share of a config file's cells, cut at a newline. The
+// first pass counts the integers in it (and notes the first and last, and
+// where anything else turns up); the second sets the cells, skipping the
+// first integer when it finishes a pair the chunk before started. shared
+// is set when other chunks are setting cells at the same time.
+typedef struct parse_chunk {
+	const char *start;
+	const char *end;
+	Board *earth;
+	int pass;
+	int shared;
+	int skip_first;
+	long long count;
+	long long first;
+	long long last;
+	const char *stop;
+} ParseChunk;
+
+// How many connections a rank's listening socket queues.
+#define LISTENQ 8
+
+// How many times, a tenth of a second apart, a rank tries to reach the
+// next one, which may not be listening yet.
+#define CONNECT_TRIES 300
+
+// A distributed run: each of num_ranks processes owns a band of rows and
+// keeps halo rows of the bands above and below it, which it gets over the
+// up and down sockets every halo generations. own_rows is the size of the
+// band itself. children holds the other ranks' process ids when this
+// process launched them.
+typedef struct ranks {
+	int rank;
+	int num_ranks;
+	int halo;
+	int own_rows;
+	int listenfd;
+	int up;
+	int down;
+	pid_t *children;
+	long long step_usec;
+	long long exchange_usec;
+} Ranks;
+
+// Each --autotune trial runs enough iterations to take at least
+// AUTOTUNE_USEC, and counts the best of AUTOTUNE_REPEATS runs.
+#define AUTOTUNE_USEC 20000
+#define AUTOTUNE_REPEATS 2
+
+// What dequeTake and dequeSteal return instead of a band.
+#define DEQUE_EMPTY -1
+#define DEQUE_ABORT -2
+
+// One thread's bands for a generation, as a Chase-Lev work-stealing deque:
+// the owner pushes and takes at the bottom, thieves steal from the top. The
+// indices only ever grow, so the deque is refilled each generation without
+// resetting it under a thief.
+typedef struct band_deque {
+	_Alignas(64) atomic_llong top;
+	_Alignas(64) atomic_llong bottom;
+	atomic_int *bands;
+	int capacity;
+} BandDeque;
+
+// The work-stealing scheduler: the board is cut into num_bands bands of
+// band_rows rows, and deques holds every thread's deque.
+typedef struct scheduler {
+	int band_rows;
+	int num_bands;
+	int num_threads;
+	BandDeque *deques;
+} Scheduler;
+
+// The most NUMA nodes -A and the -p node report know about, and how many
+// pages of a thread's rows the report asks the kernel about.
+#define MAX_NODES 64
+#define NODE_SAMPLES 64
+
+// How far the slowest strip may run over the average before -b moves the
+// strip boundaries, as a fraction of the average.
+#define REBALANCE_SLACK 0.1
+
+// Number of entries in the lookup table: one per 4x4 block of cells.
+#define LIFE_TABLE_SIZE 65536
+
+// Marks a missing HashLife node or result. Node 0 is a dummy that is never
+// handed out, so it is safe to follow after running out of memory.
+#define HL_NONE 0
+
+// Largest jump the HashLife engine takes at once is 2^HL_MAX_STEP.
+#define HL_MAX_STEP 58
+
+// Default HashLife memory budget in MB (-m).
+#define HL_DEFAULT_MB 512
+
+// A node of the HashLife quadtree. Level 2 nodes are 4x4 leaves holding
+// their cells in child[0] (same layout as a lookup table index); a level k
+// node covers 2^k x 2^k cells with four level k - 1 children in nw, ne, sw,
+// se order. Nodes are hash-consed, so equal subtrees are the same node.
+// result is the centre 2^(k-1) square advanced 2^result_step generations.
+typedef struct hl_node {
+	uint32_t child[4];
+	uint32_t next;
+	uint32_t result;
+	uint8_t level;
+	uint8_t result_step;
+	uint8_t mark;
+} HLNode;
+
+// One entry of the memo used while building a window of the periodic
+// torus: the node for the 2^level square whose top-left cell is (y, x).
+typedef struct hl_build_entry {
+	int64_t y;
+	int64_t x;
+	uint32_t level;
+	uint32_t node;
+} HLBuildEntry;
+
+// The HashLife engine: a pool of nodes indexed by hash-consing buckets,
+// bounded by capacity, plus the table used for the 8x8 base case. The memo
+// used to build each window is kept for the next one and takes built_cost
+// nodes' worth of the budget, until the cache is flushed.
+typedef struct hashlife {
+	HLNode *nodes;
+	uint32_t num_nodes;
+	uint32_t allocated;
+	uint32_t capacity;
+	uint32_t live_nodes;
+	uint32_t free_list;
+	uint32_t *buckets;
+	uint32_t bucket_mask;
+	uint32_t root;
+	uint32_t root_result;
+	int overflow;
+	int min_level;
+	const uint8_t *table;
+	HLBuildEntry *built;
+	size_t built_size;
+	size_t built_count;
+	uint32_t built_cost;
+} HashLife;
+
+// A live cell of the sparse engine.
+typedef struct sparse_cell {
+	int row;
+	int col;
+} SparseCell;
+
+// One slot of the sparse engine's neighbor count table. key is
+// row << 32 | col, or SPARSE_EMPTY for an unused slot.
+typedef struct sparse_slot {
+	uint64_t key;
+	uint8_t count;
+	uint8_t alive;
+} SparseSlot;
+
+#define SPARSE_EMPTY UINT64_MAX
+
+// The sparse engine: the list of live cells plus the table their neighbor
+// counts are gathered into each generation, and a hash of the live cells
+// for cycle detection.
+typedef struct sparse {
+	SparseCell *live;
+	size_t population;
+	size_t live_size;
+	SparseSlot *slots;
+	size_t num_slots;
+	uint64_t hash;
+} Sparse;
+
+// Default tile edge, in cells, for activity tracking.
+#define TILE_DEFAULT_SIZE 64
+
+// Activity tracking for the word-parallel engines. The board is cut into
+// tiles of tile_rows rows by tile_words words, and changed holds, for each
+// tile, the last generation in which any of its cells changed. A tile only
+// needs computing when it or one of its 8 neighbors changed in the previous
+// generation. Strips need not line up with tile rows, so two threads may
+// stamp the same tile; the stamps are atomic and only ever move forward, so
+// a thread that is behind (under NEIGHBOR sync) can't undo a newer stamp.
+typedef struct tiles {
+	int tile_rows;
+	int tile_words;
+	int tiles_down;
+	int tiles_across;
+	atomic_llong *changed;
+} Tiles;
+
+// How many past board hashes cycle detection keeps; this is also the
+// longest period it can spot.
+#define CYCLE_HISTORY 128
+
+// The board hash after each of the last CYCLE_HISTORY generations, for
+// spotting a board that repeats an earlier one. hash is the newest, from
+// generation. A matching hash is only a lead: the board is kept in seen,
+// and the cycle counts once the board at generation check, period
+// generations on, is the same one. Threads looking for the same cycle
+// share seen.
+typedef struct history {
+	uint64_t hash;
+	long long generation;
+	uint64_t hashes[CYCLE_HISTORY];
+	long long check;
+	int period;
+	Board *seen;
+} History;
+
 // Creates and defines a thread struct that contains info on where the row 
-// starts out and ends as well as its given neighbors
+// starts out and ends as well as its given neighbors. A static block can
+// also cover only words word_start..word_end - 1 of each row. earth and next
+// are the thread's view of the shared front/back board pair; every thread
+// swaps its pointers after each generation so they always agree. When looking
+// for cycles each thread keeps its own history and leaves the change its
+// strip made to the board hash in hash_deltas, two slots per thread
+// alternating by generation, so every thread reaches the same verdict without
+// another barrier. With the work-stealing scheduler, band_start..band_end - 1
+// are the bands the thread queues up itself each generation, and row_start
+// and row_end are pointed at each band in turn. Under NEIGHBOR sync, deps
+// lists the threads whose strips this one has to wait for, and strips holds
+// every thread's progress. With temporal blocking each thread also has a
+// private pair of boards holding its strip and time_block rows either side.
+// In a distributed run, ranks is the rank the board is a band of.
 typedef struct threads {
 	int row_start;
 	int row_end;
+	int word_start;
+	int word_end;
 	int neighbors;
 	int print_thread;
-	char *earth;
+	int cpu;
+	const Board *initial;
+	Board *earth;
+	Board *next;
+	ByteBoard *bytes;
+	ByteBoard *next_bytes;
+	uint8_t *col_sums;
+	const uint8_t *life_table;
+	Tiles *tiles;
+	int time_block;
+	Board *block;
+	Board *block_next;
+	Scheduler *scheduler;
+	int band_start;
+	int band_end;
+	long long bands_done;
+	long long bands_stolen;
+	SyncMode sync_mode;
+	SpinBarrier *spin_barrier;
+	unsigned int sense;
+	StripSync *flags;
+	int rounds;
+	uint32_t episode;
+	Wavefront *wavefront;
+	StripSync *strips;
+	int *deps;
+	int num_deps;
+	int rebalance;
+	long long next_rebalance;
+	long long rebalances;
+	long long busy;
+	long long *loads;
+	int *cuts;
+	History *history;
+	uint64_t hash_delta;
+	uint64_t *hash_deltas;
+	int num_threads;
+	Engine engine;
 	int tid;
 	int verbose;
+	Renderer *renderer;
+	Ranks *ranks;
 	pthread_barrier_t *BARRIER;
 	init_data *bounds;
 } Threads;
 
 void Pthread_barrier_wait(pthread_barrier_t *BARRIER);
 
-char *initEarth(char *config_file, init_data *bounds, int verbose);
+void runLife(Board *earth, init_data *bounds, Options options, struct timeval *elapsed,
+		Ranks *ranks);
+
+const char *checkOptions(Options *options, int num_rows, int num_cols);
+
+long long trialTime(const Board *earth, const init_data *bounds, Options options,
+		long long generations, long long cutoff);
+
+void autotune(const Board *earth, const init_data *bounds, Options *options,
+		const char *cache_file);
+
+int tuneCacheLoad(const char *cache_file, const char *host, const init_data *bounds,
+		Options *options);
+
+void tuneCacheSave(const char *cache_file, const char *host, const init_data *bounds,
+		const Options *options);
+
+void runBatch(const char *jobs_file, Options options, const char *rule_text);
+
+void runUniverses(const char *list_file, Options options, const char *rule_text);
+
+Universes *universesAlloc(int num_rows, int num_cols, int lanes);
+
+void universesFree(Universes *universes);
+
+void refreshUniverseHalo(Universes *universes);
+
+void stepUniverses(const Universes *cur, Universes *next, int row_start, int row_end,
+		Engine engine, Rule rule);
+
+void *universeWorker(void *args);
+
+void *batchWorker(void *args);
+
+void runSmallJob(BatchJob *job, const Options *options);
+
+long long boardPopulation(const Board *board);
+
+const char *checkRanks(Ranks *ranks, const char *peers, const Options *options,
+		const init_data *bounds);
+
+char *launchRanks(Ranks *ranks);
+
+void waitRanks(Ranks *ranks);
+
+char *peerAddress(const char *peers, int rank, char **port);
+
+void rankConnect(Ranks *ranks, const char *peers);
+
+void rankRows(int num_rows, int num_ranks, int rank, int *row_start, int *row_end);
+
+void runRanks(Board *earth, init_data *bounds, Options options, Ranks *ranks,
+		const char *peers, struct timeval *elapsed);
+
+void exchangeHalo(Ranks *ranks, Board *local, int own_rows);
+
+void rankExchange(Threads *thread_data, long long generation);
+
+long long rankStop(const Threads *thread_data, long long generation, long long end);
+
+void gatherBands(Ranks *ranks, Board *earth, int row_start, int row_end);
+
+void sendAll(int fd, const void *buf, size_t bytes);
+
+void recvAll(int fd, void *buf, size_t bytes);
+
+Board *initEarth(char *config_file, init_data *bounds, int verbose);
+
+Board *loadEarth(char *config_file, init_data *bounds, int verbose, const char **error);
+
+Board *readRle(const char *text, const char *end, init_data *bounds, const char **error);
+
+void writeRle(const Board *earth, Rule rule, const char *rle_file);
+
+void ruleText(Rule rule, char *text);
+
+char *readFile(int fd, size_t *size);
+
+void parseCells(Board *earth, const char *text, const char *end);
+
+void *parseChunk(void *args);
+
+Board *boardAlloc(int num_rows, int num_cols);
+
+void boardFree(Board *board);
+
+void refreshHalo(Board *board, int row_start, int row_end);
+
+void refreshBlockHalo(const Board *cur, Board *next, int row_start, int row_end,
+		int word_start, int word_end, Rule rule);
+
+void copyRegion(const Board *src, Board *dst, int row_start, int row_end,
+		int word_start, int word_end);
+
+int regionNode(const Board *board, int row_start, int row_end, int word_start, int word_end);
+
+void pickGrid(int num_threads, int num_rows, int num_cols, int max_cols,
+		int *grid_rows, int *grid_cols);
+
+ByteBoard *byteBoardAlloc(int num_rows, int num_cols);
+
+void byteBoardFree(ByteBoard *board);
+
+void refreshByteHalo(ByteBoard *board, int row_start, int row_end);
+
+void unpackBoard(const Board *board, ByteBoard *bytes, int row_start, int row_end);
+
+void packBoard(const ByteBoard *bytes, Board *board, int row_start, int row_end);
+
+void printEarth(Board *earth, long long iteration);
+
+Renderer *renderCreate(int num_rows, int num_cols);
+
+int renderPush(Renderer *renderer, const Board *board, long long iteration, int wait);
+
+void renderLast(Renderer *renderer, const Board *board, long long iteration);
+
+void renderFree(Renderer *renderer);
+
+void *renderFunc(void *args);
+
+int simulateLife(Threads *thread_data, long long generation, long long remaining);
+
+int stepRows(Threads *thread_data, long long generation, long long remaining);
+
+int stepBands(Threads *thread_data, long long generation, long long remaining);
+
+void homeRegion(const Threads *thread_data, int *row_start, int *row_end,
+		int *word_start, int *word_end);
+
+void firstTouch(Threads *thread_data);
+
+long long threadTime();
+
+void rebalanceRows(Threads *thread_data, const long long *loads, long long generation);
+
+void dequePush(BandDeque *deque, int band);
+
+int dequeTake(BandDeque *deque);
 
-void printEarth(char *earth, init_data bounds, int iteration);
+int dequeSteal(BandDeque *deque);
 
-void simulateLife(Threads *thread_data);
+int neighbors(Board *earth, int row, int col);
 
-int neighbors(char *earth, int index, init_data bounds);
+void stepBitBlock(const Board *cur, Board *next, int row_start, int row_end,
+		int w_start, int w_end, Engine engine, Rule rule);
+
+int blockChanged(const Board *cur, const Board *next, int row_start, int row_end,
+		int w_start, int w_end, uint64_t *hash);
+
+uint64_t boardHash(const Board *board);
+
+int boardsEqual(const Board *a, const Board *b);
+
+static inline uint64_t mix64(uint64_t x);
+
+void historyInit(History *history, uint64_t hash, Board *seen);
+
+int historyAdd(History *history, uint64_t hash);
+
+int historyConfirm(History *history, const Board *board, int keeper);
+
+void reportCycle(int period, int extinct, long long generation);
+
+Tiles *tilesCreate(const Board *board, int tile_size);
+
+void tilesFree(Tiles *tiles);
+
+void stepBitTiles(Threads *thread_data, long long generation, uint64_t *hash);
+
+int stepTimeBlock(Threads *thread_data, long long remaining);
+
+int stripDependencies(const Threads *thread_data, int num_threads, int tid, int reach,
+		int *deps);
+
+void stripWait(StripSync *strip, uint32_t generation);
+
+void stripPublish(StripSync *strip, uint32_t generation);
+
+void barrierWait(Threads *thread_data);
+
+void spinBarrierWait(SpinBarrier *barrier, unsigned int *sense);
+
+void disseminationWait(Threads *thread_data);
+
+long long stepWavefront(Threads *thread_data, long long iterations);
+
+int claimBand(Wavefront *wavefront, int first, long long iterations);
+
+void stepColumnSums(const ByteBoard *cur, ByteBoard *next, uint8_t *col_sums,
+		int row_start, int row_end, Rule rule);
+
+void buildLifeTable(Rule rule, uint8_t *table);
+
+void stepLookupRows(const Board *cur, Board *next, const uint8_t *table,
+		int row_start, int row_end, int w_start, int w_end);
+
+void stepLookupRows2(const Board *cur, Board *next, const uint8_t *table,
+		int row_start, int row_end);
+
+HashLife *hashlifeCreate(size_t mem_bytes, const uint8_t *table, const Board *board);
+
+void hashlifeFree(HashLife *hl);
+
+void hashlifeRun(HashLife *hl, Board *earth, long long iterations, Renderer *renderer);
+
+Sparse *sparseCreate(const Board *board);
+
+void sparseFree(Sparse *sp);
+
+void sparseStep(Sparse *sp, Rule rule, int num_rows, int num_cols);
+
+void sparseWriteBoard(const Sparse *sp, Board *board);
+
+void sparseRun(Board *earth, init_data *bounds, Renderer *renderer, int detect);
+
+int parseRule(const char *text, Rule *rule);
+
+int isConway(Rule rule);
+
+Engine parseEngine(const char *name);
+
+SyncMode parseSync(const char *name);
+
+const char *syncName(SyncMode sync_mode);
+
+Partition parsePartition(const char *name);
+
+const char *partitionName(Partition partition);
+
+int parseCpuList(const char *text, int *cpus, int max_cpus);
+
+int cpuOrder(const char *spec, int *order);
+
+Engine bestEngine();
+
+const char *engineName(Engine engine);
 
 void timeDiff (struct timeval *result, struct timeval *start, struct timeval *end);
 
@@ -70,12 +840,111 @@ void usage ();
 
 int open_clientfd(char *hostname, char *port);
 
+int open_listenfd(char *port);
+
 char *getFile(char *config_file);
 
 void listRemoteFiles();
 
 void *threadFunc(void *args);
 
+/**
+ * Returns a pointer to the word holding the cell at (row, col). Works for the
+ * halo ring too (row -1..num_rows, col -2..num_cols + 1) without any
+ * division.
+ **/
+static inline uint64_t *cellWord(const Board *board, int row, int col) {
+	return board->cells + (ptrdiff_t)row * board->row_pitch
+		+ ((col + WORD_BITS) >> 6) - 1;
+}
+
+/**
+ * Returns 1 if the cell at (row, col) is alive and 0 otherwise.
+ **/
+static inline int getCell(const Board *board, int row, int col) {
+	return (*cellWord(board, row, col) >> (col & (WORD_BITS - 1))) & 1;
+}
+
+/**
+ * Sets the cell at (row, col) to alive (1) or dead (0).
+ **/
+static inline void setCell(Board *board, int row, int col, int alive) {
+	uint64_t *word = cellWord(board, row, col);
+	uint64_t bit = (uint64_t)1 << (col & (WORD_BITS - 1));
+	if (alive) { *word |= bit; }
+	else { *word &= ~bit; }
+}
+
+/**
+ * Reads the next integer in [*pos, end), skipping the whitespace before
+ * it. Returns 1 and moves *pos past it, or 0 at the end of the text or at
+ * anything that is not an integer, with *pos left there. Values too big for
+ * a long long stop at LLONG_MAX rather than overflow.
+ **/
+static inline int scanInt(const char **pos, const char *end, long long *value) {
+	const char *p = *pos;
+	while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) { ++p; }
+	*pos = p;
+	int negative = 0;
+	if (p < end && (*p == '-' || *p == '+')) { negative = *p++ == '-'; }
+	if (p == end || (unsigned)(*p - '0') > 9) { return 0; }
+	long long v = 0;
+	for (; p < end && (unsigned)(*p - '0') <= 9; ++p) {
+		int digit = *p - '0';
+		v = v > (LLONG_MAX - digit) / 10 ? LLONG_MAX : v * 10 + digit;
+	}
+	*value = negative ? -v : v;
+	*pos = p;
+	return 1;
+}
+
+/**
+ * Sets a cell read from a config file alive, or says why it can't be.
+ * With shared set, other threads may be setting cells in the same word.
+ **/
+static inline void placeCell(Board *earth, long long col, long long row, int shared) {
+	if (row < 0 || row >= earth->num_rows || col < 0 || col >= earth->num_cols) {
+		printf("ERROR: cell (%lld, %lld) is off the board\n", col, row);
+		return;
+	}
+	uint64_t *word = cellWord(earth, row, col);
+	uint64_t bit = (uint64_t)1 << (col & (WORD_BITS - 1));
+	if (shared) { __atomic_fetch_or(word, bit, __ATOMIC_RELAXED); }
+	else { *word |= bit; }
+}
+
+/**
+ * Sets run cells of a row alive starting at col, a word at a time.
+ **/
+static inline void setRun(Board *board, int row, int col, int run) {
+	uint64_t *cells = board->cells + (ptrdiff_t)row * board->row_pitch;
+	while (run > 0) {
+		int bit = col & (WORD_BITS - 1);
+		int n = WORD_BITS - bit < run ? WORD_BITS - bit : run;
+		uint64_t mask = n == WORD_BITS ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1;
+		cells[col / WORD_BITS] |= mask << bit;
+		col += n;
+		run -= n;
+	}
+}
+
+/**
+ * Returns the first column from col on whose cell is not alive (or, with
+ * alive 0, not dead), or num_cols if the run reaches the end of the row.
+ **/
+static inline int runEnd(const uint64_t *cells, int col, int num_cols, int alive) {
+	while (col < num_cols) {
+		uint64_t word = cells[col / WORD_BITS];
+		uint64_t differ = (alive ? ~word : word) >> (col & (WORD_BITS - 1));
+		if (differ != 0) {
+			col += __builtin_ctzll(differ);
+			break;
+		}
+		col = (col | (WORD_BITS - 1)) + 1;
+	}
+	return col < num_cols ? col : num_cols;
+}
+
 
 /**
  *
@@ -96,9 +965,37 @@ int main(int argc, char *argv[]) {
 	int c = -1;
 	int num_threads = 4;
 	int p_flag = 0;
+	Engine engine = bestEngine();
+	char *rule_text = NULL;
+	long hashlife_mb = HL_DEFAULT_MB;
+	int tile_size = TILE_DEFAULT_SIZE;
+	int detect = 0;
+	int time_block = 1;
+	SyncMode sync_mode = SYNC_PTHREAD;
+	Partition partition = NUM_PARTITIONS;
+	char *affinity = NULL;
+	int rebalance = 0;
+	int tune = 0;
+	char *tune_cache = NULL;
+	Ranks ranks = { .rank = -1, .num_ranks = 0, .halo = 1, .listenfd = -1, .up = -1, .down = -1 };
+	char *peers = NULL;
+	char *batch_file = NULL;
+	char *universes_file = NULL;
+	long long iterations = -1;
+	char *rle_file = NULL;
 	// Variable to determine if -c or -n option is already specified.
 	int corn = 0;
-	while ((c = getopt(argc, argv, "vc:ln:t:p")) != -1) {
+	static struct option long_options[] = {
+		{"autotune", optional_argument, NULL, OPT_AUTOTUNE},
+		{"ranks", required_argument, NULL, OPT_RANKS},
+		{"rank", required_argument, NULL, OPT_RANK},
+		{"peers", required_argument, NULL, OPT_PEERS},
+		{"halo", required_argument, NULL, OPT_HALO},
+		{"batch", required_argument, NULL, OPT_BATCH},
+		{"universes", required_argument, NULL, OPT_UNIVERSES},
+		{NULL, 0, NULL, 0}
+	};
+	while ((c = getopt_long(argc, argv, "vc:ln:t:pe:r:m:s:dk:S:P:A:b:i:o:", long_options, NULL)) != -1) {
 		switch (c) {
 			case 'v':
 				// Enable verbose mode.
@@ -143,79 +1040,609 @@ int main(int argc, char *argv[]) {
 				if (p_flag) 
 					printf("PRINT THREAD PARTITION ENABLED\n");
 				break;	
+			case 'e':
+				// Select the step kernel.
+				engine = parseEngine(optarg);
+				break;
+			case 'r':
+				// Override the rule; applied once the board is loaded.
+				rule_text = optarg;
+				break;
+			case 'i':
+				// Override the iteration count; applied once the board is
+				// loaded.
+				iterations = strtoll(optarg, NULL, 10);
+				if (iterations < 0) { usage(); }
+				break;
+			case 'o':
+				// Write the final board to this file as RLE.
+				rle_file = optarg;
+				break;
+			case 'm':
+				// Set the HashLife memory budget in MB.
+				hashlife_mb = strtol(optarg, NULL, 10);
+				if (hashlife_mb < 1) { usage(); }
+				break;
+			case 's':
+				// Set the activity tracking tile size; 0 turns it off.
+				tile_size = strtol(optarg, NULL, 10);
+				if (tile_size < 0) { usage(); }
+				break;
+			case 'd':
+				// Stop early once the board dies out or repeats.
+				detect = 1;
+				break;
+			case 'k':
+				// Set how many generations run between synchronizations.
+				time_block = strtol(optarg, NULL, 10);
+				if (time_block < 1) { usage(); }
+				break;
+			case 'S':
+				// Select how the threads keep in step.
+				sync_mode = parseSync(optarg);
+				break;
+			case 'P':
+				// Select how rows are handed out to the threads.
+				partition = parsePartition(optarg);
+				break;
+			case 'A':
+				// Pin the threads to CPUs.
+				affinity = optarg;
+				break;
+			case 'b':
+				// Set how many generations run between rebalances.
+				rebalance = strtol(optarg, NULL, 10);
+				if (rebalance < 0) { usage(); }
+				break;
+			case OPT_AUTOTUNE:
+				// Pick the engine, threads and tile size by timing them,
+				// remembering the pick in the file if one is given.
+				tune = 1;
+				tune_cache = optarg;
+				break;
+			case OPT_RANKS:
+				// Split the board across that many processes.
+				ranks.num_ranks = strtol(optarg, NULL, 10);
+				if (ranks.num_ranks < 1) { usage(); }
+				break;
+			case OPT_RANK:
+				// Run one rank of a distributed run started elsewhere.
+				ranks.rank = strtol(optarg, NULL, 10);
+				if (ranks.rank < 0) { usage(); }
+				break;
+			case OPT_PEERS:
+				// Where every rank listens, in rank order.
+				peers = optarg;
+				break;
+			case OPT_HALO:
+				// Set how many generations run between halo exchanges.
+				ranks.halo = strtol(optarg, NULL, 10);
+				if (ranks.halo < 1) { usage(); }
+				break;
+			case OPT_BATCH:
+				// Run every board listed in the file instead of one.
+				batch_file = optarg;
+				break;
+			case OPT_UNIVERSES:
+				// Step every board listed in the file together.
+				universes_file = optarg;
+				break;
+			default:
+				usage();
 		}
 	}
+	if (!tune) { printf("%s engine\n", engineName(engine)); }
 
 	// Locals
-	int i = 0;
 	init_data bounds;
+	Options options = {
+		.verbose = verbose,
+		.p_flag = p_flag,
+		.num_threads = num_threads,
+		.engine = engine,
+		.hashlife_mb = hashlife_mb,
+		.tile_size = tile_size,
+		.detect = detect,
+		.time_block = time_block,
+		.sync_mode = sync_mode,
+		.partition = partition,
+		.affinity = affinity,
+		.rebalance = rebalance,
+		.iterations = iterations,
+	};
+
+	// A batch loads its own boards, and so do bit-sliced universes.
+	if (universes_file != NULL) {
+		if (batch_file != NULL || tune || ranks.num_ranks > 0 || ranks.rank >= 0) {
+			printf("ERROR: --universes does not work with --batch, --autotune or ranks\n");
+			exit(1);
+		}
+		runUniverses(universes_file, options, rule_text);
+		return 0;
+	}
+	if (batch_file != NULL) {
+		if (tune || ranks.num_ranks > 0 || ranks.rank >= 0) {
+			printf("ERROR: --batch does not work with --autotune or ranks\n");
+			exit(1);
+		}
+		runBatch(batch_file, options, rule_text);
+		return 0;
+	}
 
-	// Call the function to initialize our game board.
-	char *earth = initEarth(config_file, &bounds, verbose);	
+	// Call the function to initialize our game board, and time it apart
+	// from the run.
+	struct timeval load_start, load_end, load_diff;
+	gettimeofday(&load_start, NULL);
+	Board *earth = initEarth(config_file, &bounds, verbose);	
 	if (earth == NULL) {
 		printf("ERROR: initialization failed\n");
 	}
+	gettimeofday(&load_end, NULL);
+	timeDiff(&load_diff, &load_start, &load_end);
 
-	// Make sure the user isn't trying to run an unreasonable amount of
-	// threads.
-	if(num_threads < 1 || num_threads > bounds.num_rows){
-		perror("Too little or too many threads\nGOOD BYE!\n");
+	// A rule or iteration count given on the command line wins over the
+	// one from the file.
+	if (rule_text != NULL && !parseRule(rule_text, &bounds.rule)) {
+		printf("ERROR: could not parse rule %s\n", rule_text);
 		exit(1);
 	}
+	if (iterations >= 0) { bounds.iterations = iterations; }
 
-	// Initialize the array of threads and array of structs for the
-	// corresponding thread data
-	Threads *thread_data;
-	pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
-	thread_data = malloc(num_threads * sizeof(Threads));	
+	if (tune && ranks.num_ranks == 0 && ranks.rank < 0) {
+		autotune(earth, &bounds, &options, tune_cache);
+	}
 
-	// Declare and initialize the barrier	
-	pthread_barrier_t BARRIER;
-	int check = pthread_barrier_init(&BARRIER, NULL, num_threads);
-	if (check != 0) {
-		perror("pthread error\n");
-		exit(1);
+	// Run it and report how long that took. In a distributed run only rank
+	// 0 ends up with the whole board; when it launched the others, it also
+	// waits for them to exit.
+	struct timeval game_diff;
+	if (ranks.num_ranks > 0 || ranks.rank >= 0) {
+		const char *error = checkRanks(&ranks, peers, &options, &bounds);
+		if (error == NULL && tune) { error = "a distributed run does not work with --autotune"; }
+		if (error != NULL) {
+			printf("ERROR: %s\n", error);
+			exit(1);
+		}
+		char *launched = NULL;
+		if (ranks.rank < 0) {
+			launched = launchRanks(&ranks);
+			peers = launched;
+		}
+		runRanks(earth, &bounds, options, &ranks, peers, &game_diff);
+		free(launched);
+		if (ranks.rank != 0) {
+			boardFree(earth);
+			return 0;
+		}
+		waitRanks(&ranks);
 	}
-	// Initialize the thread data structs.
-	for (i = 0; i < num_threads; ++i) {
-		// divide the threads by their start and end rows.
-		if (i == 0) { thread_data[i].row_start = 0; }
-		else { thread_data[i].row_start = thread_data[i - 1].row_end + 1; }
-		if (i < (bounds.num_rows % num_threads)) { thread_data[i].row_end = thread_data[i].row_start + (bounds.num_rows / num_threads); }
-		else { thread_data[i].row_end = thread_data[i].row_start + (bounds.num_rows / num_threads) - 1; }
-		
-		// If print per thread is allowed then set that flag here.
-		if (p_flag == 1) { thread_data[i].print_thread = 1; }
-		
-		// Specify the very first thread to print out the board if in verbose.
-		if (verbose == 1 && i == 0) { thread_data[i].verbose = 1; }
-		else { thread_data[i].verbose = 0; }
+	else {
+		runLife(earth, &bounds, options, &game_diff, NULL);
+	}
+	if (rle_file != NULL) { writeRle(earth, bounds.rule, rle_file); }
+	printf("Time to load %s: %ld.%06ld seconds\n", config_file, load_diff.tv_sec, load_diff.tv_usec);
+	printf("Time for %lld iterations: %ld.%06ld seconds\n", bounds.iterations, game_diff.tv_sec, game_diff.tv_usec);
+
+	boardFree(earth);
+	return 0;
+}
+
+/**
+ *
+ * runLife
+ *
+ * Runs a board for bounds->iterations generations with the given options,
+ * and leaves the final generation in the board. Exits with an error if the
+ * options don't work together.
+ *
+ * @param earth; the board, with its halo ring filled in.
+ * @param bounds; the board's size, iterations and rule.
+ * @param options; how to run it.
+ * @param elapsed; set to the time the simulation itself took.
+ * @param ranks; in a distributed run, the rank the board is a band of,
+ * 			which trades halo rows with its neighbors every halo
+ * 			generations; otherwise NULL.
+ * @return void.
+ **/
+void runLife(Board *earth, init_data *bounds, Options options, struct timeval *elapsed,
+		Ranks *ranks) {
+	const char *error = checkOptions(&options, bounds->num_rows, bounds->num_cols);
+	if (error != NULL) {
+		printf("ERROR: %s\n", error);
+		exit(1);
+	}
+	int verbose = options.verbose;
+	int p_flag = options.p_flag;
+	int num_threads = options.num_threads;
+	Engine engine = options.engine;
+	long hashlife_mb = options.hashlife_mb;
+	int tile_size = options.tile_size;
+	int detect = options.detect;
+	int time_block = options.time_block;
+	SyncMode sync_mode = options.sync_mode;
+	Partition partition = options.partition;
+	char *affinity = options.affinity;
+	int rebalance = options.rebalance;
+	int fixed_rows = time_block > 1 || sync_mode == SYNC_NEIGHBOR || sync_mode == SYNC_WAVEFRONT;
+
+	// The lookup table engines step through a table built from the rule.
+	uint8_t *life_table = NULL;
+	if (engine == ENGINE_LUT || engine == ENGINE_LUT2 || engine == ENGINE_HASHLIFE) {
+		life_table = malloc(LIFE_TABLE_SIZE);
+		if (life_table == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		buildLifeTable(bounds->rule, life_table);
+	}
+
+	// Allocate the back board once; each generation is written into it and
+	// the two boards are swapped, so the main loop never allocates.
+	Board *next = boardAlloc(bounds->num_rows, bounds->num_cols);
+
+	// The word-parallel engines skip quiet tiles, which leaves them as they
+	// were in the back board, so it has to start out as a copy (each thread
+	// makes its own part of it in firstTouch).
+	Tiles *tiles = NULL;
+	if (tile_size > 0 && time_block == 1 && (engine == ENGINE_WORD || engine == ENGINE_SSE2
+				|| engine == ENGINE_AVX2)) {
+		tiles = tilesCreate(earth, tile_size);
+	}
+
+	// The column-sum engine works on a byte-per-cell copy of the board,
+	// which the threads fill in firstTouch.
+	ByteBoard *bytes = NULL;
+	ByteBoard *next_bytes = NULL;
+	if (engine == ENGINE_COLSUM) {
+		bytes = byteBoardAlloc(bounds->num_rows, bounds->num_cols);
+		next_bytes = byteBoardAlloc(bounds->num_rows, bounds->num_cols);
+	}
+
+	// Work out which CPU each thread is pinned to.
+	int *cpu_order = NULL;
+	int num_cpus = 0;
+	if (affinity != NULL) {
+		cpu_order = malloc(CPU_SETSIZE * sizeof(int));
+		if (cpu_order == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		num_cpus = cpuOrder(affinity, cpu_order);
+		if (num_cpus < 1) {
+			printf("ERROR: no usable CPUs in %s\n", affinity);
+			exit(1);
+		}
+	}
+
+	// Initialize the array of threads and array of structs for the
+	// corresponding thread data
+	int i = 0;
+	Threads *thread_data;
+	pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+	thread_data = malloc(num_threads * sizeof(Threads));	
+
+	// Cycle detection hashes the bit-packed board one generation at a time,
+	// so the engines that keep their own boards or take bigger steps can't
+	// use it; sparse keeps its own hash.
+	History *histories = NULL;
+	uint64_t *hash_deltas = NULL;
+	Board *seen = NULL;
+	if (detect && engine != ENGINE_SPARSE) {
+		histories = malloc(num_threads * sizeof(History));
+		hash_deltas = calloc(2 * num_threads, sizeof(uint64_t));
+		if (histories == NULL || hash_deltas == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		seen = boardAlloc(earth->num_rows, earth->num_cols);
+		uint64_t hash = boardHash(earth);
+		for (i = 0; i < num_threads; ++i) { historyInit(&histories[i], hash, seen); }
+	}
+
+	// Declare and initialize the barrier	
+	pthread_barrier_t BARRIER;
+	int check = pthread_barrier_init(&BARRIER, NULL, num_threads);
+	if (check != 0) {
+		perror("pthread error\n");
+		exit(1);
+	}
+	SpinBarrier *spin_barrier = NULL;
+	if (sync_mode == SYNC_SPIN) {
+		spin_barrier = aligned_alloc(sizeof(SpinBarrier), sizeof(SpinBarrier));
+		if (spin_barrier == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		atomic_init(&spin_barrier->count, 0);
+		atomic_init(&spin_barrier->sense, 0);
+		atomic_init(&spin_barrier->waiters, 0);
+		spin_barrier->num_threads = num_threads;
+	}
+	// The dissemination barrier gives each thread one flag per round, which
+	// another thread bumps to the barrier's episode number.
+	int rounds = 0;
+	while ((1 << rounds) < num_threads) { ++rounds; }
+	StripSync *flags = NULL;
+	if (sync_mode == SYNC_DISSEMINATION && rounds > 0) {
+		flags = aligned_alloc(sizeof(StripSync), (size_t)num_threads * rounds * sizeof(StripSync));
+		if (flags == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		for (i = 0; i < num_threads * rounds; ++i) {
+			atomic_init(&flags[i].done, 0);
+			atomic_init(&flags[i].waiters, 0);
+		}
+	}
+	// Split the board into a grid of blocks, one per thread. Rows only
+	// when the engine, -k or neighbor sync need whole rows (or bands are
+	// stolen instead). Blocks split rows on word boundaries, so a wide board
+	// can take more threads than it has rows.
+	int grid_rows = num_threads;
+	int grid_cols = 1;
+	if (partition == PARTITION_STATIC) {
+		int whole_rows = fixed_rows || rebalance || engine == ENGINE_COLSUM || engine == ENGINE_LUT2;
+		pickGrid(num_threads, bounds->num_rows, bounds->num_cols,
+				whole_rows ? 1 : earth->row_words, &grid_rows, &grid_cols);
+	}
+	int row_words = earth->row_words;
+
+	// Linux puts a page on the NUMA node of the thread that first writes
+	// it, so the threads copy their own rows out of the loaded board into
+	// fresh, untouched ones before the first generation.
+	Board *initial = NULL;
+	if (engine != ENGINE_HASHLIFE && engine != ENGINE_SPARSE) {
+		initial = earth;
+		earth = boardAlloc(bounds->num_rows, bounds->num_cols);
+	}
+
+	// Under -b every thread works out the same new strip boundaries from
+	// the time each strip took, which the threads post here: two sets, so
+	// the next round's posts never overwrite ones still being read.
+	long long *loads = NULL;
+	if (rebalance) {
+		loads = calloc(2 * num_threads, sizeof(long long));
+		if (loads == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+	}
+
+	// Initialize the thread data structs.
+	for (i = 0; i < num_threads; ++i) {
+		// divide the threads by their start and end rows, and words.
+		int block_row = i / grid_cols;
+		int block_col = i % grid_cols;
+		thread_data[i].row_start = block_row * (bounds->num_rows / grid_rows)
+			+ (block_row < bounds->num_rows % grid_rows ? block_row : bounds->num_rows % grid_rows);
+		thread_data[i].row_end = thread_data[i].row_start + (bounds->num_rows / grid_rows) - 1
+			+ (block_row < bounds->num_rows % grid_rows);
+		thread_data[i].word_start = block_col * (row_words / grid_cols)
+			+ (block_col < row_words % grid_cols ? block_col : row_words % grid_cols);
+		thread_data[i].word_end = thread_data[i].word_start + (row_words / grid_cols)
+			+ (block_col < row_words % grid_cols);
+		
+		// If print per thread is allowed then set that flag here.
+		if (p_flag == 1) { thread_data[i].print_thread = 1; }
+		
+		// Specify the very first thread to print out the board if in verbose.
+		if (verbose == 1 && i == 0) { thread_data[i].verbose = 1; }
+		else { thread_data[i].verbose = 0; }
+		thread_data[i].renderer = NULL;
+		thread_data[i].ranks = ranks;
 		
 		// Give each thread the data required to run. 
-		thread_data[i].bounds = &bounds;
+		thread_data[i].bounds = bounds;
+		thread_data[i].cpu = cpu_order != NULL ? cpu_order[i % num_cpus] : -1;
+		thread_data[i].initial = initial;
 		thread_data[i].earth = earth;
+		thread_data[i].next = next;
+		thread_data[i].bytes = bytes;
+		thread_data[i].next_bytes = next_bytes;
+		thread_data[i].col_sums = NULL;
+		thread_data[i].life_table = life_table;
+		thread_data[i].tiles = tiles;
+		thread_data[i].scheduler = NULL;
+		thread_data[i].band_start = 0;
+		thread_data[i].band_end = 0;
+		thread_data[i].bands_done = 0;
+		thread_data[i].bands_stolen = 0;
+		thread_data[i].sync_mode = sync_mode;
+		thread_data[i].spin_barrier = spin_barrier;
+		thread_data[i].sense = 0;
+		thread_data[i].flags = flags;
+		thread_data[i].rounds = rounds;
+		thread_data[i].episode = 0;
+		thread_data[i].wavefront = NULL;
+		thread_data[i].strips = NULL;
+		thread_data[i].deps = NULL;
+		thread_data[i].num_deps = 0;
+		thread_data[i].time_block = time_block;
+		thread_data[i].block = NULL;
+		thread_data[i].block_next = NULL;
+		// Each thread's private boards cover its strip and the halo rows.
+		if (time_block > 1) {
+			int block_rows = thread_data[i].row_end - thread_data[i].row_start + 1 + 2 * time_block;
+			thread_data[i].block = boardAlloc(block_rows, bounds->num_cols);
+			thread_data[i].block_next = boardAlloc(block_rows, bounds->num_cols);
+		}
+		thread_data[i].rebalance = rebalance;
+		thread_data[i].next_rebalance = rebalance;
+		thread_data[i].rebalances = 0;
+		thread_data[i].busy = 0;
+		thread_data[i].loads = loads;
+		thread_data[i].cuts = NULL;
+		thread_data[i].history = histories != NULL ? &histories[i] : NULL;
+		thread_data[i].hash_delta = 0;
+		thread_data[i].hash_deltas = hash_deltas;
+		thread_data[i].num_threads = num_threads;
+		thread_data[i].engine = engine;
+		// Each column-sum thread keeps its own running sums for a row,
+		// halo columns included.
+		if (engine == ENGINE_COLSUM) {
+			thread_data[i].col_sums = malloc(bounds->num_cols + 2);
+			if (thread_data[i].col_sums == NULL) {
+				printf("ERROR: memory allocation failed\n");
+				exit(1);
+			}
+		}
 		thread_data[i].tid = i;
 		thread_data[i].BARRIER = &BARRIER;
 		thread_data[i].print_thread = p_flag;
 	}
 
+	// Each thread keeps its own copy of where every strip starts, and room
+	// for the old one while it works out the new one.
+	for (i = 0; rebalance && i < num_threads; ++i) {
+		thread_data[i].cuts = malloc(2 * (num_threads + 1) * sizeof(int));
+		if (thread_data[i].cuts == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		for (int j = 0; j < num_threads; ++j) { thread_data[i].cuts[j] = thread_data[j].row_start; }
+		thread_data[i].cuts[num_threads] = bounds->num_rows;
+	}
+
+	// The work-stealing scheduler and wavefront sync cut the board into
+	// bands the height of a tile, or shorter if that would leave fewer than
+	// about four per thread.
+	int band_rows = tile_size > 0 ? tile_size : TILE_DEFAULT_SIZE;
+	if (band_rows > bounds->num_rows / (4 * num_threads)) {
+		band_rows = bounds->num_rows / (4 * num_threads);
+	}
+	if (band_rows < 1) { band_rows = 1; }
+	int num_bands = (bounds->num_rows + band_rows - 1) / band_rows;
+
+	// The scheduler gives each thread an even share of the bands to start
+	// from.
+	Scheduler scheduler;
+	scheduler.deques = NULL;
+	if (partition == PARTITION_STEAL) {
+		scheduler.band_rows = band_rows;
+		scheduler.num_bands = num_bands;
+		scheduler.num_threads = num_threads;
+		scheduler.deques = aligned_alloc(sizeof(BandDeque), num_threads * sizeof(BandDeque));
+		if (scheduler.deques == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		for (i = 0; i < num_threads; ++i) {
+			BandDeque *deque = &scheduler.deques[i];
+			thread_data[i].scheduler = &scheduler;
+			thread_data[i].band_start = (int)((long long)i * scheduler.num_bands / num_threads);
+			thread_data[i].band_end = (int)((long long)(i + 1) * scheduler.num_bands / num_threads);
+			atomic_init(&deque->top, 0);
+			atomic_init(&deque->bottom, 0);
+			deque->capacity = thread_data[i].band_end - thread_data[i].band_start;
+			if (deque->capacity < 1) { deque->capacity = 1; }
+			deque->bands = malloc(deque->capacity * sizeof(atomic_int));
+			if (deque->bands == NULL) {
+				printf("ERROR: memory allocation failed\n");
+				exit(1);
+			}
+		}
+	}
+
+	// Under WAVEFRONT sync every band starts at generation 0.
+	Wavefront wavefront;
+	wavefront.bands = NULL;
+	if (sync_mode == SYNC_WAVEFRONT) {
+		wavefront.band_rows = band_rows;
+		wavefront.num_bands = num_bands;
+		wavefront.boards[0] = earth;
+		wavefront.boards[1] = next;
+		wavefront.bands = aligned_alloc(sizeof(WaveBand), num_bands * sizeof(WaveBand));
+		if (wavefront.bands == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		for (i = 0; i < num_bands; ++i) {
+			atomic_init(&wavefront.bands[i].generation, 0);
+			atomic_init(&wavefront.bands[i].busy, 0);
+		}
+		atomic_init(&wavefront.progress.done, 0);
+		atomic_init(&wavefront.progress.waiters, 0);
+		atomic_init(&wavefront.finished, 0);
+		for (i = 0; i < num_threads; ++i) { thread_data[i].wavefront = &wavefront; }
+	}
+
+	// Under NEIGHBOR sync each thread waits for the strips within reach of
+	// its own: the rows one step reads, times the generations it takes.
+	StripSync *strips = NULL;
+	if (sync_mode == SYNC_NEIGHBOR) {
+		strips = aligned_alloc(sizeof(StripSync), num_threads * sizeof(StripSync));
+		if (strips == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		int reach = engine == ENGINE_LUT2 ? 2 : time_block;
+		for (i = 0; i < num_threads; ++i) {
+			atomic_init(&strips[i].done, 0);
+			atomic_init(&strips[i].waiters, 0);
+			thread_data[i].strips = strips;
+			thread_data[i].deps = malloc(num_threads * sizeof(int));
+			if (thread_data[i].deps == NULL) {
+				printf("ERROR: memory allocation failed\n");
+				exit(1);
+			}
+			thread_data[i].num_deps = stripDependencies(thread_data, num_threads, i, reach,
+					thread_data[i].deps);
+		}
+	}
+
+	// In verbose mode the boards are printed by a thread of their own.
+	Renderer *renderer = NULL;
+	if (verbose) { renderer = renderCreate(bounds->num_rows, bounds->num_cols); }
+	thread_data[0].renderer = renderer;
+
 	// Declare the time structs and get the start time.
-	struct timeval game_start, game_end, game_diff;
+	struct timeval game_start, game_end;
 	gettimeofday(&game_start, NULL);
 	
-	//Creates the threads that will be used to divide up and run gol
-	for (i = 0; i < num_threads; i++){
-		pthread_create(&threads[i], NULL, threadFunc,&thread_data[i]);
+	// HashLife and the sparse engine run on the main thread instead of the
+	// strips. A rank stops them every halo generations to trade rows.
+	if (engine == ENGINE_HASHLIFE || engine == ENGINE_SPARSE) {
+		HashLife *hl = NULL;
+		if (engine == ENGINE_HASHLIFE) {
+			hl = hashlifeCreate((size_t)hashlife_mb << 20, life_table, earth);
+		}
+		init_data part = *bounds;
+		long long done = 0;
+		do {
+			part.iterations = bounds->iterations - done;
+			if (ranks != NULL) {
+				if (done > 0) { exchangeHalo(ranks, earth, ranks->own_rows); }
+				if (part.iterations > ranks->halo) { part.iterations = ranks->halo; }
+			}
+			if (hl != NULL) { hashlifeRun(hl, earth, part.iterations, renderer); }
+			else { sparseRun(earth, &part, renderer, detect); }
+			done += part.iterations;
+		} while (done < bounds->iterations);
+		hashlifeFree(hl);
 	}
-	//Joins the threads together to the main thread
-	for(i = 0; i< num_threads; i++){
-		pthread_join(threads[i], NULL);
+	else {
+		//Creates the threads that will be used to divide up and run gol
+		for (i = 0; i < num_threads; i++){
+			pthread_create(&threads[i], NULL, threadFunc,&thread_data[i]);
+		}
+		//Joins the threads together to the main thread
+		for(i = 0; i< num_threads; i++){
+			pthread_join(threads[i], NULL);
+		}
 	}
 	
 	// Stop the timer and calculate the elapsed time.
 	gettimeofday(&game_end, NULL);
-	timeDiff(&game_diff, &game_start, &game_end);
-	printf("Time for %d iterations: %ld.%06ld seconds\n", bounds.iterations, game_diff.tv_sec, game_diff.tv_usec);
+	timeDiff(elapsed, &game_start, &game_end);
+
+	// Let the renderer catch up.
+	renderFree(renderer);
+
+	// Hand the final generation back in the caller's board.
+	if (initial != NULL) {
+		memcpy(initial->base, thread_data[0].earth->base,
+				(size_t)(bounds->num_rows + 2) * initial->row_pitch * sizeof(uint64_t));
+	}
 	
 	// Destroy the barrier.
 	check = pthread_barrier_destroy(&BARRIER);
@@ -225,326 +1652,5300 @@ int main(int argc, char *argv[]) {
 	}
 
 	//Frees all allocated memory
-	free(earth);
+	free(cpu_order);
+	// HashLife and sparse ran in the caller's board instead of their own.
+	if (initial != NULL) { boardFree(earth); }
+	boardFree(next);
+	byteBoardFree(bytes);
+	byteBoardFree(next_bytes);
+	free(life_table);
+	tilesFree(tiles);
+	free(histories);
+	free(hash_deltas);
+	if (seen != NULL) { boardFree(seen); }
+	for (i = 0; i < num_threads; ++i) {
+		free(thread_data[i].col_sums);
+		boardFree(thread_data[i].block);
+		boardFree(thread_data[i].block_next);
+		free(thread_data[i].deps);
+		free(thread_data[i].cuts);
+	}
+	free(loads);
+	free(strips);
+	free(wavefront.bands);
+	free(spin_barrier);
+	free(flags);
+	if (scheduler.deques != NULL) {
+		for (i = 0; i < num_threads; ++i) { free(scheduler.deques[i].bands); }
+		free(scheduler.deques);
+	}
 	free(threads);
 	free(thread_data);
+}
+
+/**
+ *
+ * trialTime
+ *
+ * Times a short run of a copy of the board, for --autotune. The run is
+ * quiet: no printing and no cycle detection.
+ *
+ * @param earth; the board, which is left as it is.
+ * @param bounds; the board's size and rule.
+ * @param options; how to run it.
+ * @param generations; how many iterations to run.
+ * @param cutoff; a time in microseconds past which a run isn't repeated,
+ * 		since it has already lost; 0 always repeats.
+ * @return the best time of AUTOTUNE_REPEATS runs in microseconds, or -1
+ * 		if the options don't work on this board.
+ **/
+long long trialTime(const Board *earth, const init_data *bounds, Options options,
+		long long generations, long long cutoff) {
+	options.verbose = 0;
+	options.p_flag = 0;
+	options.detect = 0;
+	// A static partition can leave threads out; that count isn't worth timing.
+	int num_threads = options.num_threads;
+	if (checkOptions(&options, bounds->num_rows, bounds->num_cols) != NULL
+			|| options.num_threads != num_threads) {
+		return -1;
+	}
+	init_data trial = *bounds;
+	trial.iterations = generations;
+	Board *board = boardAlloc(bounds->num_rows, bounds->num_cols);
+	long long best = -1;
+	for (int repeat = 0; repeat < AUTOTUNE_REPEATS; ++repeat) {
+		memcpy(board->base, earth->base,
+				(size_t)(bounds->num_rows + 2) * board->row_pitch * sizeof(uint64_t));
+		struct timeval elapsed;
+		runLife(board, &trial, options, &elapsed, NULL);
+		long long usec = elapsed.tv_sec * 1000000LL + elapsed.tv_usec;
+		if (best < 0 || usec < best) { best = usec; }
+		if (cutoff > 0 && best > cutoff) { break; }
+	}
+	boardFree(board);
+	return best;
+}
+
+/**
+ *
+ * autotune
+ *
+ * Picks the engine, thread count and tile size that run this board
+ * fastest here, one at a time: the engine with a thread per CPU, then the
+ * thread count for that engine, then the tile size if it uses tiles. The
+ * trials run just enough iterations to be worth timing. Scalar and
+ * hashlife aren't tried: scalar never wins, and a short run says nothing
+ * about how hashlife does on a long one. Sparse is only tried on boards
+ * with few enough live cells that it stands a chance, since on a full one
+ * it can take minutes. The rest of the options stay as given.
+ *
+ * @param earth; the board.
+ * @param bounds; the board's size, iterations and rule.
+ * @param options; the options, updated with the pick.
+ * @param cache_file; where picks are kept, or NULL.
+ * @return void.
+ **/
+void autotune(const Board *earth, const init_data *bounds, Options *options,
+		const char *cache_file) {
+	char host[256] = "unknown";
+	gethostname(host, sizeof(host) - 1);
+	if (cache_file != NULL && tuneCacheLoad(cache_file, host, bounds, options)) {
+		printf("autotune: %s engine, %d threads, tile size %d (from %s)\n",
+				engineName(options->engine), options->num_threads, options->tile_size, cache_file);
+		return;
+	}
+
+	cpu_set_t allowed;
+	int num_cpus = 1;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) { num_cpus = CPU_COUNT(&allowed); }
+
+	// Find how many iterations make a trial long enough to time.
+	Options trial = *options;
+	trial.engine = bestEngine();
+	trial.num_threads = 1;
+	trial.tile_size = TILE_DEFAULT_SIZE;
+	long long generations = 1;
+	int trials = 0;
+	for (;;) {
+		long long usec = trialTime(earth, bounds, trial, generations, 0);
+		++trials;
+		if (usec < 0 || usec >= AUTOTUNE_USEC || generations >= bounds->iterations) { break; }
+		generations = 2 * generations < bounds->iterations ? 2 * generations : bounds->iterations;
+	}
+
+	long long population = boardPopulation(earth);
+
+	// The engine, with a thread per CPU if the board takes that many.
+	Engine engines[] = { ENGINE_WORD, ENGINE_SSE2, ENGINE_AVX2, ENGINE_LUT, ENGINE_LUT2,
+		ENGINE_COLSUM, ENGINE_SPARSE };
+	Options best = trial;
+	long long best_usec = -1;
+	for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); ++e) {
+		if ((engines[e] == ENGINE_SSE2 || engines[e] == ENGINE_AVX2) && engines[e] > bestEngine()) {
+			continue;
+		}
+		if (engines[e] == ENGINE_SPARSE
+				&& population > (long long)earth->num_rows * earth->num_cols / 64) {
+			continue;
+		}
+		trial.engine = engines[e];
+		trial.num_threads = engines[e] == ENGINE_SPARSE ? 1 : num_cpus;
+		long long usec = trialTime(earth, bounds, trial, generations, best_usec);
+		if (usec < 0 && trial.num_threads > 1) {
+			trial.num_threads = 1;
+			usec = trialTime(earth, bounds, trial, generations, best_usec);
+		}
+		++trials;
+		if (usec >= 0 && (best_usec < 0 || usec < best_usec)) {
+			best = trial;
+			best_usec = usec;
+		}
+	}
+
+	// The thread count: powers of two up to the number of CPUs.
+	trial = best;
+	for (int threads = 1; best.engine != ENGINE_SPARSE; threads *= 2) {
+		if (threads > num_cpus) { threads = num_cpus; }
+		trial.num_threads = threads;
+		long long usec = trialTime(earth, bounds, trial, generations, best_usec);
+		++trials;
+		if (usec >= 0 && usec < best_usec) {
+			best = trial;
+			best_usec = usec;
+		}
+		if (threads == num_cpus) { break; }
+	}
+
+	// The tile size, for the engines that skip quiet tiles.
+	trial = best;
+	if (options->time_block == 1 && (best.engine == ENGINE_WORD || best.engine == ENGINE_SSE2
+				|| best.engine == ENGINE_AVX2)) {
+		int sizes[] = { 0, 16, 32, 128, 256 };
+		for (size_t t = 0; t < sizeof(sizes) / sizeof(sizes[0]); ++t) {
+			trial.tile_size = sizes[t];
+			long long usec = trialTime(earth, bounds, trial, generations, best_usec);
+			++trials;
+			if (usec >= 0 && usec < best_usec) {
+				best = trial;
+				best_usec = usec;
+			}
+		}
+	}
+
+	options->engine = best.engine;
+	options->num_threads = best.num_threads;
+	options->tile_size = best.tile_size;
+	printf("autotune: %s engine, %d threads, tile size %d (%d trials of %lld iterations)\n",
+			engineName(options->engine), options->num_threads, options->tile_size, trials,
+			generations);
+	if (cache_file != NULL) { tuneCacheSave(cache_file, host, bounds, options); }
+}
+
+/**
+ *
+ * tuneCacheLoad
+ *
+ * Looks up an earlier --autotune pick for a board of this size on this
+ * host. The file has a line per pick: host, rows, columns, engine, threads
+ * and tile size. A pick that no longer works (an engine this CPU lacks,
+ * or clashing options) is passed over.
+ *
+ * @param cache_file; the file.
+ * @param host; this host's name.
+ * @param bounds; the board's size.
+ * @param options; updated with the pick if there is one.
+ * @return 1 if a pick was found, 0 otherwise.
+ **/
+int tuneCacheLoad(const char *cache_file, const char *host, const init_data *bounds,
+		Options *options) {
+	FILE *file = fopen(cache_file, "r");
+	if (file == NULL) { return 0; }
+	char line[512];
+	int found = 0;
+	while (!found && fgets(line, sizeof(line), file) != NULL) {
+		char line_host[256];
+		char name[32];
+		int rows, cols, threads, tile_size;
+		if (sscanf(line, "%255s %d %d %31s %d %d", line_host, &rows, &cols, name, &threads,
+					&tile_size) != 6) {
+			continue;
+		}
+		if (strcmp(line_host, host) != 0 || rows != bounds->num_rows || cols != bounds->num_cols) {
+			continue;
+		}
+		Options cached = *options;
+		cached.engine = NUM_ENGINES;
+		for (int e = 0; e < NUM_ENGINES; ++e) {
+			if (strcmp(name, engineName(e)) == 0) { cached.engine = e; }
+		}
+		cached.num_threads = threads;
+		cached.tile_size = tile_size;
+		if (cached.engine == NUM_ENGINES || tile_size < 0 || ((cached.engine == ENGINE_SSE2
+						|| cached.engine == ENGINE_AVX2) && cached.engine > bestEngine())
+				|| checkOptions(&cached, bounds->num_rows, bounds->num_cols) != NULL) {
+			continue;
+		}
+		options->engine = cached.engine;
+		options->num_threads = threads;
+		options->tile_size = tile_size;
+		found = 1;
+	}
+	fclose(file);
+	return found;
+}
+
+/**
+ *
+ * tuneCacheSave
+ *
+ * Records an --autotune pick, replacing any earlier one for a board of the
+ * same size on the same host.
+ *
+ * @param cache_file; the file.
+ * @param host; this host's name.
+ * @param bounds; the board's size.
+ * @param options; the pick.
+ * @return void.
+ **/
+void tuneCacheSave(const char *cache_file, const char *host, const init_data *bounds,
+		const Options *options) {
+	// Keep every other line.
+	char *kept = NULL;
+	size_t kept_len = 0;
+	FILE *file = fopen(cache_file, "r");
+	if (file != NULL) {
+		char line[512];
+		while (fgets(line, sizeof(line), file) != NULL) {
+			char line_host[256];
+			int rows, cols;
+			if (sscanf(line, "%255s %d %d", line_host, &rows, &cols) == 3
+					&& strcmp(line_host, host) == 0 && rows == bounds->num_rows
+					&& cols == bounds->num_cols) {
+				continue;
+			}
+			size_t len = strlen(line);
+			char *grown = realloc(kept, kept_len + len + 1);
+			if (grown == NULL) {
+				printf("ERROR: memory allocation failed\n");
+				exit(1);
+			}
+			kept = grown;
+			memcpy(kept + kept_len, line, len + 1);
+			kept_len += len;
+		}
+		fclose(file);
+	}
+
+	file = fopen(cache_file, "w");
+	if (file == NULL) {
+		printf("ERROR: could not write %s\n", cache_file);
+		free(kept);
+		return;
+	}
+	if (kept != NULL) { fputs(kept, file); }
+	fprintf(file, "%s %d %d %s %d %d\n", host, bounds->num_rows, bounds->num_cols,
+			engineName(options->engine), options->num_threads, options->tile_size);
+	fclose(file);
+	free(kept);
+}
+
+/**
+ *
+ * runBatch
+ *
+ * Runs every board listed in a file, one config file per line (blank lines
+ * and lines starting with # are skipped), and prints what each one ended up
+ * as and how long it took. A pool of worker threads, started once, loads and
+ * runs the small boards, each on its own; the big ones then run one at a
+ * time with all the threads. The options apply to every board. A board
+ * that can't be loaded is reported and skipped, and the batch then exits
+ * with an error once the rest have run.
+ *
+ * @param jobs_file; the file listing the boards.
+ * @param options; how to run the boards.
+ * @param rule_text; a rule for every board instead of its own, or NULL.
+ * @return void.
+ **/
+void runBatch(const char *jobs_file, Options options, const char *rule_text) {
+	if (options.verbose || options.detect || options.time_block > 1
+			|| options.engine == ENGINE_COLSUM) {
+		printf("ERROR: --batch does not work with -v, -d, -k or colsum\n");
+		exit(1);
+	}
+	Rule rule;
+	if (rule_text != NULL && !parseRule(rule_text, &rule)) {
+		printf("ERROR: could not parse rule %s\n", rule_text);
+		exit(1);
+	}
+
+	// Read the list of boards.
+	FILE *file = fopen(jobs_file, "r");
+	if (file == NULL) {
+		printf("ERROR: %s could not be opened\n", jobs_file);
+		exit(1);
+	}
+	Batch batch = { .jobs = NULL, .num_jobs = 0, .options = options,
+		.rule = rule_text != NULL ? &rule : NULL };
+	atomic_init(&batch.next_job, 0);
+	int capacity = 0;
+	char line[4096];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0' || line[0] == '#') { continue; }
+		if (batch.num_jobs == capacity) {
+			capacity = capacity ? 2 * capacity : 64;
+			BatchJob *grown = realloc(batch.jobs, capacity * sizeof(BatchJob));
+			if (grown == NULL) {
+				printf("ERROR: memory allocation failed\n");
+				exit(1);
+			}
+			batch.jobs = grown;
+		}
+		BatchJob *job = &batch.jobs[batch.num_jobs++];
+		memset(job, 0, sizeof(BatchJob));
+		job->config_file = strdup(line);
+	}
+	fclose(file);
+
+	struct timeval batch_start, batch_end, batch_diff;
+	gettimeofday(&batch_start, NULL);
+
+	// The workers take jobs until there are none left, leaving the big
+	// boards loaded for afterwards.
+	int num_workers = options.num_threads;
+	if (num_workers > batch.num_jobs) { num_workers = batch.num_jobs; }
+	pthread_t *workers = malloc(num_workers * sizeof(pthread_t));
+	if (workers == NULL && num_workers > 0) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	for (int w = 0; w < num_workers; ++w) {
+		pthread_create(&workers[w], NULL, batchWorker, &batch);
+	}
+	for (int w = 0; w < num_workers; ++w) {
+		pthread_join(workers[w], NULL);
+	}
+	free(workers);
+	options.p_flag = 0;
+	for (int j = 0; j < batch.num_jobs; ++j) {
+		BatchJob *job = &batch.jobs[j];
+		if (job->earth == NULL) { continue; }
+		struct timeval elapsed;
+		runLife(job->earth, &job->bounds, options, &elapsed, NULL);
+		job->usec = elapsed.tv_sec * 1000000LL + elapsed.tv_usec;
+		job->population = boardPopulation(job->earth);
+		job->hash = boardHash(job->earth);
+		boardFree(job->earth);
+		job->earth = NULL;
+	}
+
+	gettimeofday(&batch_end, NULL);
+	timeDiff(&batch_diff, &batch_start, &batch_end);
+	int failed = 0;
+	for (int j = 0; j < batch.num_jobs; ++j) {
+		BatchJob *job = &batch.jobs[j];
+		if (job->error != NULL) {
+			printf("ERROR: job %d: %s: %s\n", j, job->config_file, job->error);
+			free(job->config_file);
+			++failed;
+			continue;
+		}
+		printf("Job %d:\t%s\t%dx%d\t%lld iterations\t%lld alive\thash %016llx\t%lld.%06lld seconds\n",
+				j, job->config_file, job->bounds.num_rows, job->bounds.num_cols,
+				job->bounds.iterations, job->population, (unsigned long long)job->hash,
+				job->usec / 1000000, job->usec % 1000000);
+		free(job->config_file);
+	}
+	// Only the jobs that ran count towards the rate.
+	int completed = batch.num_jobs - failed;
+	double seconds = batch_diff.tv_sec + batch_diff.tv_usec / 1e6;
+	printf("Time for %d jobs: %ld.%06ld seconds (%.1f jobs per second)\n", completed,
+			batch_diff.tv_sec, batch_diff.tv_usec, seconds > 0 ? completed / seconds : 0.0);
+	free(batch.jobs);
+	if (failed > 0) {
+		printf("ERROR: %d of %d jobs could not be loaded\n", failed, batch.num_jobs);
+		exit(1);
+	}
+}
+
+/**
+ *
+ * batchWorker
+ *
+ * A --batch worker: loads and runs jobs until every one has been handed
+ * out. Boards too big to run alone are left loaded in their job, and jobs
+ * whose board could not be loaded are left with the reason.
+ *
+ * @param args; the batch.
+ * @return NULL.
+ **/
+void *batchWorker(void *args) {
+	Batch *batch = (Batch*)args;
+	for (;;) {
+		int j = atomic_fetch_add_explicit(&batch->next_job, 1, memory_order_relaxed);
+		if (j >= batch->num_jobs) { break; }
+		BatchJob *job = &batch->jobs[j];
+		job->earth = loadEarth(job->config_file, &job->bounds, 0, &job->error);
+		if (job->earth == NULL) { continue; }
+		if (batch->rule != NULL) { job->bounds.rule = *batch->rule; }
+		if (batch->options.iterations >= 0) { job->bounds.iterations = batch->options.iterations; }
+		if ((long long)job->bounds.num_rows * job->bounds.num_cols > BATCH_SMALL_CELLS) {
+			continue;
+		}
+		runSmallJob(job, &batch->options);
+		boardFree(job->earth);
+		job->earth = NULL;
+	}
+	return NULL;
+}
+
+/**
+ *
+ * runSmallJob
+ *
+ * Runs a job's board on the calling thread: HashLife and the sparse
+ * engine as they always run, the others through simulateLife over the
+ * whole board, as the only thread.
+ *
+ * @param job; the job, with its board loaded.
+ * @param options; how to run it.
+ * @return void.
+ **/
+void runSmallJob(BatchJob *job, const Options *options) {
+	Board *earth = job->earth;
+	init_data *bounds = &job->bounds;
+	uint8_t *life_table = NULL;
+	if (options->engine == ENGINE_LUT || options->engine == ENGINE_LUT2
+			|| options->engine == ENGINE_HASHLIFE) {
+		life_table = malloc(LIFE_TABLE_SIZE);
+		if (life_table == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		buildLifeTable(bounds->rule, life_table);
+	}
+
+	struct timeval start, end, diff;
+	gettimeofday(&start, NULL);
+	if (options->engine == ENGINE_HASHLIFE) {
+		HashLife *hl = hashlifeCreate((size_t)options->hashlife_mb << 20, life_table, earth);
+		hashlifeRun(hl, earth, bounds->iterations, NULL);
+		hashlifeFree(hl);
+	}
+	else if (options->engine == ENGINE_SPARSE) {
+		sparseRun(earth, bounds, NULL, 0);
+	}
+	else {
+		Threads worker;
+		memset(&worker, 0, sizeof(Threads));
+		worker.row_start = 0;
+		worker.row_end = bounds->num_rows - 1;
+		worker.word_start = 0;
+		worker.word_end = earth->row_words;
+		worker.earth = earth;
+		worker.next = boardAlloc(bounds->num_rows, bounds->num_cols);
+		worker.life_table = life_table;
+		worker.time_block = 1;
+		worker.num_threads = 1;
+		worker.engine = options->engine;
+		worker.bounds = bounds;
+		for (long long i = 0; i < bounds->iterations; ) {
+			i += simulateLife(&worker, i, bounds->iterations - i);
+			Board *swap = worker.earth;
+			worker.earth = worker.next;
+			worker.next = swap;
+		}
+		// Leave the final generation in the job's board.
+		if (worker.earth != earth) {
+			memcpy(earth->base, worker.earth->base,
+					(size_t)(earth->num_rows + 2) * earth->row_pitch * sizeof(uint64_t));
+		}
+		boardFree(worker.earth != earth ? worker.earth : worker.next);
+	}
+	gettimeofday(&end, NULL);
+	timeDiff(&diff, &start, &end);
+	job->usec = diff.tv_sec * 1000000LL + diff.tv_usec;
+	job->population = boardPopulation(earth);
+	job->hash = boardHash(earth);
+	free(life_table);
+}
+
+/**
+ *
+ * runUniverses
+ *
+ * Runs up to MAX_UNIVERSES boards of the same size at once, bit-sliced.
+ * The file lists one board per line: a config file, or "random <seed>
+ * [<density>]" for a soup of the same size (density defaults to 0.5).
+ * The first line has to be a config file, and its size and iteration
+ * count go for every board. The rows are split among the threads, which
+ * meet at a barrier every generation. Prints each board's live cells at
+ * the end, and in verbose mode the final board itself.
+ *
+ * @param list_file; the file listing the boards.
+ * @param options; how to run the boards; avx2 steps four words at a time.
+ * @param rule_text; a rule for every board instead of the first one's, or
+ * 			NULL.
+ * @return void.
+ **/
+void runUniverses(const char *list_file, Options options, const char *rule_text) {
+	if (options.detect || options.time_block > 1 || options.sync_mode != SYNC_PTHREAD
+			|| options.partition != NUM_PARTITIONS || options.affinity != NULL
+			|| options.rebalance) {
+		printf("ERROR: --universes does not work with -d, -k, -S, -P, -A or -b\n");
+		exit(1);
+	}
+	if (options.num_threads < 1) {
+		printf("ERROR: too little or too many threads\n");
+		exit(1);
+	}
+	FILE *file = fopen(list_file, "r");
+	if (file == NULL) {
+		printf("ERROR: %s could not be opened\n", list_file);
+		exit(1);
+	}
+
+	// Read every board into a plain board first; the first one sets the
+	// size for the rest.
+	init_data bounds;
+	Board *boards[MAX_UNIVERSES];
+	char *sources[MAX_UNIVERSES];
+	int num_universes = 0;
+	char line[4096];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0' || line[0] == '#') { continue; }
+		if (num_universes == MAX_UNIVERSES) {
+			printf("ERROR: --universes takes at most %d boards\n", MAX_UNIVERSES);
+			exit(1);
+		}
+		unsigned long long seed;
+		double density = 0.5;
+		Board *board;
+		if (sscanf(line, "random %llu %lf", &seed, &density) >= 1) {
+			if (num_universes == 0) {
+				printf("ERROR: the first of the --universes has to be a config file\n");
+				exit(1);
+			}
+			// A splitmix64 stream, so a seed gives the same soup anywhere.
+			board = boardAlloc(bounds.num_rows, bounds.num_cols);
+			uint64_t threshold = density >= 1.0 ? UINT64_MAX : (uint64_t)(density * 18446744073709551616.0);
+			for (int row = 0; row < bounds.num_rows; ++row) {
+				for (int col = 0; col < bounds.num_cols; ++col) {
+					seed += 0x9E3779B97F4A7C15ULL;
+					setCell(board, row, col, mix64(seed) < threshold);
+				}
+			}
+		}
+		else {
+			init_data board_bounds;
+			board = initEarth(line, &board_bounds, 0);
+			if (num_universes == 0) { bounds = board_bounds; }
+			else if (board_bounds.num_rows != bounds.num_rows
+					|| board_bounds.num_cols != bounds.num_cols) {
+				printf("ERROR: %s is not %d x %d like the first board\n", line,
+						bounds.num_rows, bounds.num_cols);
+				exit(1);
+			}
+		}
+		boards[num_universes] = board;
+		sources[num_universes] = strdup(line);
+		++num_universes;
+	}
+	fclose(file);
+	if (num_universes == 0) {
+		printf("ERROR: %s lists no boards\n", list_file);
+		exit(1);
+	}
+	if (rule_text != NULL && !parseRule(rule_text, &bounds.rule)) {
+		printf("ERROR: could not parse rule %s\n", rule_text);
+		exit(1);
+	}
+	if (options.iterations >= 0) { bounds.iterations = options.iterations; }
+
+	// Slice them: bit u of a cell's words is universe u's cell.
+	int lanes = (num_universes + WORD_BITS - 1) / WORD_BITS;
+	Universes *earth = universesAlloc(bounds.num_rows, bounds.num_cols, lanes);
+	Universes *next = universesAlloc(bounds.num_rows, bounds.num_cols, lanes);
+	for (int u = 0; u < num_universes; ++u) {
+		for (int row = 0; row < bounds.num_rows; ++row) {
+			uint64_t *cells = earth->base + (size_t)(row + 1) * earth->row_words + lanes;
+			for (int col = 0; col < bounds.num_cols; ++col) {
+				cells[col * lanes + u / WORD_BITS] |= (uint64_t)getCell(boards[u], row, col) << (u % WORD_BITS);
+			}
+		}
+	}
+	refreshUniverseHalo(earth);
+
+	// Split the rows as evenly as they go, a row at least to each thread.
+	int num_threads = options.num_threads < bounds.num_rows ? options.num_threads : bounds.num_rows;
+	UniverseStrip *strips = malloc(num_threads * sizeof(UniverseStrip));
+	pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+	if (strips == NULL || threads == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	pthread_barrier_t BARRIER;
+	if (pthread_barrier_init(&BARRIER, NULL, num_threads) != 0) {
+		perror("pthread error\n");
+		exit(1);
+	}
+	for (int t = 0; t < num_threads; ++t) {
+		strips[t] = (UniverseStrip) {
+			.earth = earth,
+			.next = next,
+			.row_start = (int)((long long)bounds.num_rows * t / num_threads),
+			.row_end = (int)((long long)bounds.num_rows * (t + 1) / num_threads) - 1,
+			.tid = t,
+			.print_thread = options.p_flag,
+			.iterations = bounds.iterations,
+			.engine = options.engine,
+			.rule = bounds.rule,
+			.BARRIER = &BARRIER,
+		};
+	}
+
+	struct timeval game_start, game_end, game_diff;
+	gettimeofday(&game_start, NULL);
+	for (int t = 0; t < num_threads; ++t) {
+		pthread_create(&threads[t], NULL, universeWorker, &strips[t]);
+	}
+	for (int t = 0; t < num_threads; ++t) { pthread_join(threads[t], NULL); }
+	gettimeofday(&game_end, NULL);
+	timeDiff(&game_diff, &game_start, &game_end);
+	earth = strips[0].earth;
+	next = strips[0].next;
+	pthread_barrier_destroy(&BARRIER);
+	free(threads);
+	free(strips);
+
+	// Take them apart again.
+	for (int u = 0; u < num_universes; ++u) {
+		Board *board = boards[u];
+		for (int row = 0; row < bounds.num_rows; ++row) {
+			const uint64_t *cells = earth->base + (size_t)(row + 1) * earth->row_words + lanes;
+			for (int col = 0; col < bounds.num_cols; ++col) {
+				setCell(board, row, col, (cells[col * lanes + u / WORD_BITS] >> (u % WORD_BITS)) & 1);
+			}
+		}
+		refreshHalo(board, 0, bounds.num_rows - 1);
+		printf("Universe %d:\t%s\t%lld alive\n", u, sources[u], boardPopulation(board));
+		if (options.verbose) { printEarth(board, bounds.iterations - 1); }
+		boardFree(board);
+		free(sources[u]);
+	}
+	printf("Time for %lld iterations of %d universes: %ld.%06ld seconds\n", bounds.iterations,
+			num_universes, game_diff.tv_sec, game_diff.tv_usec);
+	universesFree(earth);
+	universesFree(next);
+}
+
+/**
+ *
+ * universeWorker
+ *
+ * Steps one thread's rows of the --universes through every generation.
+ * After each one the threads wait for each other, thread 0 refreshes the
+ * halo, and they wait again before swapping.
+ *
+ * @param args; the thread's strip.
+ * @return NULL.
+ **/
+void *universeWorker(void *args) {
+	UniverseStrip *strip = (UniverseStrip*)args;
+	for (long long i = 0; i < strip->iterations; ++i) {
+		stepUniverses(strip->earth, strip->next, strip->row_start, strip->row_end,
+				strip->engine, strip->rule);
+		pthread_barrier_wait(strip->BARRIER);
+		if (strip->tid == 0) { refreshUniverseHalo(strip->next); }
+		pthread_barrier_wait(strip->BARRIER);
+		Universes *swap = strip->earth;
+		strip->earth = strip->next;
+		strip->next = swap;
+	}
+	if (strip->print_thread == 1) {
+		printf("Thread %d:\t %d:%d\t(%d)\n", strip->tid, strip->row_start, strip->row_end,
+				strip->row_end - strip->row_start);
+	}
+	return NULL;
+}
+
+/**
+ *
+ * universesAlloc
+ *
+ * Allocates bit-sliced universes with every cell dead, halo included.
+ *
+ * @param num_rows; the number of rows on each board.
+ * @param num_cols; the number of columns on each board.
+ * @param lanes; the number of words per cell, 64 universes each.
+ * @return the universes.
+ **/
+Universes *universesAlloc(int num_rows, int num_cols, int lanes) {
+	Universes *universes = malloc(sizeof(Universes));
+	if (universes == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	universes->num_rows = num_rows;
+	universes->num_cols = num_cols;
+	universes->lanes = lanes;
+	universes->row_words = (num_cols + 2) * lanes;
+	universes->base = calloc((size_t)(num_rows + 2) * universes->row_words, sizeof(uint64_t));
+	if (universes->base == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	return universes;
+}
+
+/**
+ * Frees universes from universesAlloc.
+ **/
+void universesFree(Universes *universes) {
+	free(universes->base);
+	free(universes);
+}
+
+/**
+ * Copies the opposite edges of the torus into the halo cells of every
+ * universe at once: the end cells of each row, then the first and last
+ * rows, halo cells included.
+ **/
+void refreshUniverseHalo(Universes *universes) {
+	int lanes = universes->lanes;
+	int num_cols = universes->num_cols;
+	size_t cell_bytes = lanes * sizeof(uint64_t);
+	size_t row_bytes = universes->row_words * sizeof(uint64_t);
+	for (int row = 1; row <= universes->num_rows; ++row) {
+		uint64_t *cells = universes->base + (size_t)row * universes->row_words;
+		memcpy(cells, cells + num_cols * lanes, cell_bytes);
+		memcpy(cells + (num_cols + 1) * lanes, cells + lanes, cell_bytes);
+	}
+	memcpy(universes->base, universes->base + (size_t)universes->num_rows * universes->row_words,
+			row_bytes);
+	memcpy(universes->base + (size_t)(universes->num_rows + 1) * universes->row_words,
+			universes->base + universes->row_words, row_bytes);
+}
+
+/**
+ * Returns the number of live cells on the board, leaving out the halo
+ * columns in the last word of each row.
+ **/
+long long boardPopulation(const Board *board) {
+	uint64_t last_mask = ~(uint64_t)0;
+	if (board->num_cols % WORD_BITS) { last_mask = ((uint64_t)1 << (board->num_cols % WORD_BITS)) - 1; }
+
+	long long population = 0;
+	for (int row = 0; row < board->num_rows; ++row) {
+		const uint64_t *cells = board->cells + (ptrdiff_t)row * board->row_pitch;
+		for (int w = 0; w < board->row_words - 1; ++w) { population += __builtin_popcountll(cells[w]); }
+		population += __builtin_popcountll(cells[board->row_words - 1] & last_mask);
+	}
+	return population;
+}
+
+/**
+ *
+ * checkOptions
+ *
+ * Checks that the options work together on a board of the given size. A
+ * partition left to the default is filled in: work stealing, unless
+ * something needs each thread to keep the same rows. A static partition
+ * with more threads than the board can be cut into blocks for runs with
+ * as many as it can.
+ *
+ * @param options; the options.
+ * @param num_rows; the number of rows on the board.
+ * @param num_cols; the number of columns on the board.
+ * @return NULL if they work, or what is wrong with them.
+ **/
+const char *checkOptions(Options *options, int num_rows, int num_cols) {
+	static char message[128];
+	Engine engine = options->engine;
+	int time_block = options->time_block;
+	SyncMode sync_mode = options->sync_mode;
+
+	// Temporal blocking steps private copies of the strips through the word
+	// or lookup table kernels, and only hands back every k-th generation.
+	if (time_block > 1 && engine != ENGINE_WORD && engine != ENGINE_SSE2
+			&& engine != ENGINE_AVX2 && engine != ENGINE_LUT) {
+		snprintf(message, sizeof(message), "-k does not work with the %s engine", engineName(engine));
+		return message;
+	}
+	if (time_block > 1 && options->detect) {
+		return "-k and -d can't be used together";
+	}
+	// Work stealing is the default, but temporal blocking and neighbor sync
+	// both rely on each thread keeping the same rows. Wavefront sync hands
+	// out bands of its own, and only uses the strips to place the board.
+	int fixed_rows = time_block > 1 || sync_mode == SYNC_NEIGHBOR || sync_mode == SYNC_WAVEFRONT;
+	if (options->partition == NUM_PARTITIONS) {
+		options->partition = fixed_rows || options->rebalance ? PARTITION_STATIC : PARTITION_STEAL;
+	}
+	if (options->partition == PARTITION_STEAL && fixed_rows) {
+		return "-P steal can't be used with -k, neighbor or wavefront sync";
+	}
+	// Rebalancing moves the boundaries of static strips; work stealing
+	// balances on its own, and -k and neighbor sync size their copies and
+	// waits by the strips they start with.
+	if (options->rebalance && (options->partition == PARTITION_STEAL || fixed_rows)) {
+		return "-b can't be used with -P steal, -k, neighbor or wavefront sync";
+	}
+	// Printing and cycle detection need every strip at the same generation.
+	if ((sync_mode == SYNC_NEIGHBOR || sync_mode == SYNC_WAVEFRONT)
+			&& (options->verbose || options->detect)) {
+		snprintf(message, sizeof(message), "%s sync can't be used with -v or -d", syncName(sync_mode));
+		return message;
+	}
+	// Wavefront bands take one generation at a time on the shared boards.
+	if (sync_mode == SYNC_WAVEFRONT && (time_block > 1 || engine == ENGINE_COLSUM
+				|| engine == ENGINE_LUT2)) {
+		snprintf(message, sizeof(message), "wavefront sync does not work with -k or the %s engine",
+				engineName(engine));
+		return message;
+	}
+	// Cycle detection hashes the bit-packed board one generation at a time,
+	// so the engines that keep their own boards or take bigger steps can't
+	// use it; sparse keeps its own hash.
+	if (options->detect && (engine == ENGINE_COLSUM || engine == ENGINE_LUT2
+				|| engine == ENGINE_HASHLIFE)) {
+		snprintf(message, sizeof(message), "-d does not work with the %s engine", engineName(engine));
+		return message;
+	}
+	// Make sure the user isn't trying to run an unreasonable amount of
+	// threads. A static partition needs a block for each, so any threads
+	// past that are left out.
+	if (options->num_threads < 1) {
+		return "too little or too many threads";
+	}
+	if (options->partition == PARTITION_STATIC) {
+		int whole_rows = fixed_rows || options->rebalance || engine == ENGINE_COLSUM
+			|| engine == ENGINE_LUT2;
+		int grid_rows, grid_cols;
+		pickGrid(options->num_threads, num_rows, num_cols,
+				whole_rows ? 1 : (num_cols + WORD_BITS - 1) / WORD_BITS, &grid_rows, &grid_cols);
+		options->num_threads = grid_rows * grid_cols;
+	}
+	return NULL;
+}
+
+/**
+ * Used for testing if calls to pthread_barrier_wait worked or not
+ * Not used in this code.
+ **/
+void Pthread_barrier_wait(pthread_barrier_t *BARRIER) {
+	int check = pthread_barrier_wait(BARRIER);
+	int success = 0;
+	if (check == PTHREAD_BARRIER_SERIAL_THREAD) { 
+		success = 1;
+	}
+	if (success) { printf("success\n"); }
+}	
+
+/**
+ * threadFunc
+ *
+ * This function is a thread routine that will have each thread running it
+ * simulate the game of life
+ *
+ * @param args: gets deconstructed into a Threads struct that holds all
+ * 		necessary data for the Game of Life Simulation.
+ * @return void
+**/
+void *threadFunc(void *args) {
+	// Deconstruct the argument
+	Threads *thread_data = (Threads*)args;
+	// Pin the thread before it touches its rows, so they are placed on the
+	// node it runs on, and wait until every thread has its rows in place.
+	if (thread_data->cpu >= 0) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(thread_data->cpu, &cpus);
+		if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+			printf("ERROR: could not pin thread %d to CPU %d\n", thread_data->tid, thread_data->cpu);
+			exit(1);
+		}
+	}
+	firstTouch(thread_data);
+	barrierWait(thread_data);
+	// For each iteration (some engines advance more than one at a time):
+	long long i = 0;
+	long long end = thread_data->bounds->iterations;
+	// Under WAVEFRONT sync the bands run ahead on their own instead.
+	while (thread_data->wavefront != NULL && i < end) {
+		i = stepWavefront(thread_data, rankStop(thread_data, i, end));
+		if (i < end) { rankExchange(thread_data, i); }
+	}
+	while (i < end) {
+		
+		// Under NEIGHBOR sync, first wait for the strips around this one to
+		// finish the generation it is about to read. That also means they
+		// are done reading the board it is about to overwrite.
+		if (thread_data->sync_mode == SYNC_NEIGHBOR) {
+			for (int d = 0; d < thread_data->num_deps; ++d) {
+				stripWait(&thread_data->strips[thread_data->deps[d]], (uint32_t)i);
+			}
+		}
+
+		// Simulate life for each iteration, then wait until every thread
+		// has finished writing the back board before making it the front.
+		// One barrier is enough: nobody writes the old front board again
+		// until everyone has passed the next generation's barrier.
+		thread_data->hash_delta = 0;
+		long long started = thread_data->rebalance ? threadTime() : 0;
+		long long stop = rankStop(thread_data, i, end);
+		if (thread_data->scheduler != NULL) {
+			i += stepBands(thread_data, i, stop - i);
+		}
+		else {
+			i += stepRows(thread_data, i, stop - i);
+		}
+		if (thread_data->history != NULL) {
+			thread_data->hash_deltas[(i & 1) * thread_data->num_threads + thread_data->tid] =
+				thread_data->hash_delta;
+		}
+		// Time spent stepping the strip, posted for the next rebalance.
+		int rebalancing = thread_data->rebalance && i >= thread_data->next_rebalance && i < end;
+		const long long *loads = NULL;
+		if (thread_data->rebalance) {
+			thread_data->busy += threadTime() - started;
+			loads = thread_data->loads + (thread_data->rebalances & 1) * thread_data->num_threads;
+		}
+		if (rebalancing) {
+			thread_data->loads[(thread_data->rebalances & 1) * thread_data->num_threads
+				+ thread_data->tid] = thread_data->busy;
+			thread_data->busy = 0;
+		}
+		if (thread_data->sync_mode == SYNC_NEIGHBOR) {
+			stripPublish(&thread_data->strips[thread_data->tid], (uint32_t)i);
+		}
+		else {
+			barrierWait(thread_data);
+		}
+		Board *swap = thread_data->earth;
+		thread_data->earth = thread_data->next;
+		thread_data->next = swap;
+		ByteBoard *swap_bytes = thread_data->bytes;
+		thread_data->bytes = thread_data->next_bytes;
+		thread_data->next_bytes = swap_bytes;
+
+		// Every -b generations, move the strip boundaries so each strip
+		// should take about as long as the others.
+		if (rebalancing) {
+			rebalanceRows(thread_data, loads, i);
+			thread_data->next_rebalance = i + thread_data->rebalance;
+			++thread_data->rebalances;
+		}
+
+		// If this is the designated board for printing then hand a copy of
+		// the board to the renderer here. Nobody writes it again until this
+		// thread reaches the next barrier.
+		if (thread_data->tid == 0 && thread_data->verbose == 1) {
+			if (thread_data->engine == ENGINE_COLSUM) {
+				packBoard(thread_data->bytes, thread_data->earth, 0, thread_data->earth->num_rows - 1);
+			}
+			renderPush(thread_data->renderer, thread_data->earth, i - 1, 0);
+		}
+
+		// Fold every strip's change into the board hash and look for an
+		// earlier board it repeats. Thread 0 keeps the board a match turns
+		// up on; nobody writes earth before the next barrier, so every
+		// thread can check it against that board itself. Once the cycle is
+		// confirmed, only enough generations to land on the same phase as
+		// the full run are left.
+		if (thread_data->history != NULL && i < end) {
+			uint64_t hash = thread_data->history->hash;
+			const uint64_t *deltas = thread_data->hash_deltas + (i & 1) * thread_data->num_threads;
+			for (int t = 0; t < thread_data->num_threads; ++t) { hash ^= deltas[t]; }
+			int period = historyAdd(thread_data->history, hash);
+			if (period) {
+				period = historyConfirm(thread_data->history, thread_data->earth, thread_data->tid == 0);
+			}
+			if (period) {
+				if (thread_data->tid == 0) {
+					reportCycle(period, boardPopulation(thread_data->earth) == 0, i);
+				}
+				end = i + (end - i) % period;
+				thread_data->history = NULL;
+			}
+		}
+
+		// A rank trades rows with its neighbors every halo generations.
+		if (i == stop && i < end) { rankExchange(thread_data, i); }
+	}
+	// Leave the final generation in the bit-packed board. With more threads
+	// than rows, some strips are empty.
+	if (thread_data->engine == ENGINE_COLSUM && thread_data->row_start <= thread_data->row_end) {
+		packBoard(thread_data->bytes, thread_data->earth, thread_data->row_start, thread_data->row_end);
+	}
+	// The last board always gets printed.
+	if (thread_data->tid == 0 && thread_data->verbose == 1) {
+		renderLast(thread_data->renderer, thread_data->earth, end - 1);
+	}
+	// If printing per thread is enabled, do so here, along with the node
+	// the thread's own rows ended up on and the CPU it was pinned to.
+	barrierWait(thread_data);
+	char where[64] = "";
+	if (thread_data->print_thread == 1) {
+		int row_start, row_end, word_start, word_end;
+		homeRegion(thread_data, &row_start, &row_end, &word_start, &word_end);
+		int node = regionNode(thread_data->earth, row_start, row_end, word_start, word_end);
+		int len = node >= 0 ? snprintf(where, sizeof(where), "\tnode %d", node)
+			: snprintf(where, sizeof(where), "\tnode ?");
+		if (thread_data->cpu >= 0) {
+			snprintf(where + len, sizeof(where) - len, "\tcpu %d", thread_data->cpu);
+		}
+	}
+	if (thread_data->print_thread == 1 && thread_data->wavefront != NULL) {
+		printf("Thread %d:\t %lld bands%s\n", thread_data->tid, thread_data->bands_done, where);
+	}
+	else if (thread_data->print_thread == 1 && thread_data->scheduler != NULL) {
+		printf("Thread %d:\t %lld bands\t(%lld stolen)%s\n", thread_data->tid,
+				thread_data->bands_done, thread_data->bands_stolen, where);
+	}
+	else if (thread_data->print_thread == 1 && thread_data->word_end - thread_data->word_start
+			< thread_data->earth->row_words) {
+		int col_end = thread_data->word_end * WORD_BITS;
+		if (col_end > thread_data->earth->num_cols) { col_end = thread_data->earth->num_cols; }
+		printf("Thread %d:\t %d:%d\t(%d)\tcols %d:%d%s\n", thread_data->tid, thread_data->row_start,
+				thread_data->row_end, thread_data->row_end - thread_data->row_start,
+				thread_data->word_start * WORD_BITS, col_end - 1, where);
+	}
+	else if (thread_data->print_thread == 1) {
+		printf("Thread %d:\t %d:%d\t(%d)%s\n", thread_data->tid, thread_data->row_start, 
+				thread_data->row_end, thread_data->row_end - thread_data->row_start, where);
+	} /* When each thread is done then return */
+	barrierWait(thread_data);
+	return NULL;
+}
+
+
+/**
+ *
+ * Usage 
+ *
+ * Prints out the possible command line options.
+ *
+ * @param None 
+ * @return void.
+ **/
+void usage () {
+	printf("Command line should look like:\n");
+	printf("./gol (-v) -c <configuration file>; OR\n");
+	printf("./gol -l; OR\n");
+	printf("./gol (-v) -n <server-configuration file>\n");
+	printf("-v enables verbose mode\n");
+	printf("-t <threads> sets the number of threads\n");
+	printf("-p prints the rows each thread worked on\n");
+	printf("-e <engine> selects the step kernel: scalar, word, sse2, avx2, colsum,\n");
+	printf("   lut, lut2, hashlife or sparse (lut2 advances, and prints, two iterations\n");
+	printf("   at a time; hashlife runs on one thread and prints after each jump; sparse\n");
+	printf("   runs on one thread and only visits live cells and their neighbors)\n");
+	printf("   (defaults to the widest one this CPU supports)\n");
+	printf("-s <cells> sets the tile size word, sse2 and avx2 use to skip quiet parts\n");
+	printf("   of the board (default %d; 0 computes every cell every iteration)\n", TILE_DEFAULT_SIZE);
+	printf("-k <generations> lets each thread run that many iterations on its own\n");
+	printf("   copy of its rows between synchronizations, and prints only every k-th\n");
+	printf("   (word, sse2, avx2 and lut engines; default 1)\n");
+	printf("-S <sync> sets how the threads keep in step: pthread (a barrier every\n");
+	printf("   iteration; the default), spin (a barrier that spins before sleeping;\n");
+	printf("   cheaper when iterations are short), dissemination (like spin, but\n");
+	printf("   with no single counter; for 64 threads or more), neighbor (each\n");
+	printf("   thread only waits for the strips next to its own) or wavefront (no\n");
+	printf("   iterations: any thread steps any band whose neighbors have caught up;\n");
+	printf("   not with -k, colsum or lut2); neither neighbor nor wavefront with -v or -d\n");
+	printf("-P <partition> sets how rows are handed out: steal (bands that idle\n");
+	printf("   threads take from busy ones; the default) or static (one fixed strip\n");
+	printf("   per thread; implied by -k and neighbor sync)\n");
+	printf("-b <generations> moves the strip boundaries that often, so strips that\n");
+	printf("   took longer get fewer rows (static strips only; -p logs each move)\n");
+	printf("-A <cpus> pins the threads to CPUs: compact (fill one NUMA node before\n");
+	printf("   the next), scatter (round-robin across nodes) or a list like 0,2,4-7;\n");
+	printf("   thread i gets the i-th CPU, wrapping around\n");
+	printf("-d stops early once the board dies out, stops changing or repeats with a\n");
+	printf("   period of up to %d, and reports it (not with colsum, lut2 or hashlife)\n", CYCLE_HISTORY);
+	printf("-m <MB> caps the memory hashlife uses for its node cache (default %d)\n", HL_DEFAULT_MB);
+	printf("--autotune[=<file>] times short runs of the board to pick the engine,\n");
+	printf("   thread count and tile size, overriding -e, -t and -s; with a file, the\n");
+	printf("   pick is kept there for the next board of the same size on this host\n");
+	printf("--batch=<file> runs every config file listed in the file, one per\n");
+	printf("   line, on a pool of -t threads that each run small boards alone, and\n");
+	printf("   prints each board's live cells, hash and time (not with -v, -d, -k\n");
+	printf("   or colsum)\n");
+	printf("--universes=<file> steps up to %d boards of one size at once, one\n", MAX_UNIVERSES);
+	printf("   bit of every cell word each: the file lists config files, or lines\n");
+	printf("   like \"random <seed> [<density>]\" for soups the size of the first\n");
+	printf("   board, and each board's live cells are printed at the end (its final\n");
+	printf("   board too with -v)\n");
+	printf("--ranks=<n> splits the board into bands across n processes on this\n");
+	printf("   host, which trade the rows at their edges over TCP; -t, -e and the\n");
+	printf("   other options then apply to each band (not with -v, -d or --autotune)\n");
+	printf("--rank=<r> --peers=<host:port,...> runs rank r of a run across hosts,\n");
+	printf("   listening on the r-th address and connecting to the next\n");
+	printf("--halo=<generations> trades that many rows that often (default 1), so\n");
+	printf("   ranks wait on each other less at the cost of recomputing the halo\n");
+	printf("-r <rule> sets the rule in B/S notation, e.g. B36/S23 (default B3/S23)\n");
+	printf("-i <iterations> sets the number of iterations, overriding the file's\n");
+	printf("   (RLE files have none, so they run 0 without it)\n");
+	printf("-o <file> writes the final board to the file as RLE\n");
+	printf("Configuration files are either the project's format or RLE, read with\n");
+	printf("its rule; a rule ending in a torus like :T100,80 sets the board size\n");
+	exit(1);
+}
+
+/**
+ *
+ * renderCreate
+ *
+ * Starts the renderer thread, with an empty ring of snapshots of boards of
+ * the given size.
+ *
+ * @param num_rows; the number of rows on the board.
+ * @param num_cols; the number of columns on the board.
+ * @return the renderer.
+ **/
+Renderer *renderCreate(int num_rows, int num_cols) {
+	Renderer *renderer = aligned_alloc(_Alignof(Renderer), sizeof(Renderer));
+	if (renderer == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	for (int slot = 0; slot < RENDER_SLOTS; ++slot) {
+		renderer->frames[slot] = boardAlloc(num_rows, num_cols);
+		renderer->iterations[slot] = 0;
+	}
+	atomic_init(&renderer->pushed.done, 0);
+	atomic_init(&renderer->pushed.waiters, 0);
+	atomic_init(&renderer->popped.done, 0);
+	atomic_init(&renderer->popped.waiters, 0);
+	renderer->last = NULL;
+	renderer->last_iteration = 0;
+	renderer->last_dropped = 0;
+	renderer->dropped = 0;
+	renderer->frames_seen = 0;
+	if (pthread_create(&renderer->thread, NULL, renderFunc, renderer) != 0) {
+		printf("ERROR: could not start the renderer\n");
+		exit(1);
+	}
+	return renderer;
+}
+
+/**
+ *
+ * renderPush
+ *
+ * Hands the renderer a copy of a board to print. Only one thread pushes.
+ * If the renderer is a whole ring behind, the board is dropped, or with
+ * wait set, waited on until a slot frees up.
+ *
+ * @param renderer; the renderer.
+ * @param board; the board, or NULL to tell the renderer to stop.
+ * @param iteration; the iteration the board is the result of.
+ * @param wait; wait for a free slot instead of dropping the board.
+ * @return 1 if the board was queued, 0 if it was dropped.
+ **/
+int renderPush(Renderer *renderer, const Board *board, long long iteration, int wait) {
+	uint32_t pushed = atomic_load_explicit(&renderer->pushed.done, memory_order_relaxed);
+	uint32_t popped = atomic_load_explicit(&renderer->popped.done, memory_order_acquire);
+	if (board != NULL) { ++renderer->frames_seen; }
+	if (pushed - popped == RENDER_SLOTS) {
+		if (!wait) {
+			++renderer->dropped;
+			renderer->last_dropped = 1;
+			return 0;
+		}
+		stripWait(&renderer->popped, pushed - RENDER_SLOTS + 1);
+	}
+	int slot = pushed % RENDER_SLOTS;
+	Board *frame = renderer->frames[slot];
+	if (board != NULL) {
+		memcpy(frame->base, board->base,
+				(size_t)(board->num_rows + 2) * board->row_pitch * sizeof(uint64_t));
+	}
+	// A negative iteration tells the renderer to stop.
+	renderer->iterations[slot] = board != NULL ? iteration : -1;
+	renderer->last_dropped = 0;
+	stripPublish(&renderer->pushed, pushed + 1);
+	return 1;
+}
+
+/**
+ * Makes sure the last board of a run gets printed: if the push that
+ * carried it was dropped, the board is remembered without waiting, and
+ * renderFree queues it after the timer has stopped. The board has to
+ * outlive the call to renderFree.
+ **/
+void renderLast(Renderer *renderer, const Board *board, long long iteration) {
+	if (renderer->last_dropped) {
+		--renderer->frames_seen;
+		--renderer->dropped;
+		renderer->last = board;
+		renderer->last_iteration = iteration;
+	}
+}
+
+/**
+ *
+ * renderFree
+ *
+ * Queues the last board if renderLast held it back, waits for the renderer
+ * to print everything it was handed, stops it, and reports how many boards
+ * were dropped along the way.
+ *
+ * @param renderer; the renderer, or NULL.
+ * @return void.
+ **/
+void renderFree(Renderer *renderer) {
+	if (renderer == NULL) { return; }
+	if (renderer->last != NULL) {
+		renderPush(renderer, renderer->last, renderer->last_iteration, 1);
+		renderer->last = NULL;
+	}
+	renderPush(renderer, NULL, 0, 1);
+	pthread_join(renderer->thread, NULL);
+	if (renderer->dropped > 0) {
+		printf("Renderer dropped %lld of %lld boards\n", renderer->dropped, renderer->frames_seen);
+	}
+	for (int slot = 0; slot < RENDER_SLOTS; ++slot) { boardFree(renderer->frames[slot]); }
+	free(renderer);
+}
+
+/**
+ *
+ * renderFunc
+ *
+ * The renderer thread: prints each board in the ring, in order, until it
+ * is told to stop.
+ *
+ * @param args; the renderer.
+ * @return NULL.
+ **/
+void *renderFunc(void *args) {
+	Renderer *renderer = (Renderer*)args;
+	for (uint32_t popped = 0; ; ++popped) {
+		stripWait(&renderer->pushed, popped + 1);
+		int slot = popped % RENDER_SLOTS;
+		if (renderer->iterations[slot] < 0) { break; }
+		printEarth(renderer->frames[slot], renderer->iterations[slot]);
+		fflush(stdout);
+		stripPublish(&renderer->popped, popped + 1);
+	}
+	return NULL;
+}
+
+/**
+ *
+ * initEarth 
+ *
+ * Initializes the game board and the initial condition given by the user's
+ * specified configuration file.
+ *
+ * @param config_file; the user specified configuration file name.
+ * @param bounds; a pointer to an init_data struct holding the config file
+ * 			specifications.
+ * @param verbose; a signifier to whether or not user specifies verbose mode.
+ * @return earth; a pointer to the bit-packed game board.
+ **/
+Board *initEarth(char *config_file, init_data *bounds, int verbose){
+	const char *error = NULL;
+	Board *earth = loadEarth(config_file, bounds, verbose, &error);
+	if (earth == NULL) {
+		printf("ERROR: %s: %s\n", config_file, error);
+		exit(1);
+	}
+	return earth;
+}
+
+/**
+ *
+ * loadEarth
+ *
+ * Does the work of initEarth, but hands back why a configuration file
+ * could not be loaded instead of exiting, so a batch can go on without
+ * it.
+ *
+ * @param config_file; the user specified configuration file name.
+ * @param bounds; a pointer to an init_data struct holding the config file
+ * 			specifications.
+ * @param verbose; a signifier to whether or not user specifies verbose mode.
+ * @param error; set to the reason when the file can't be loaded.
+ * @return earth; a pointer to the bit-packed game board, or NULL.
+ **/
+Board *loadEarth(char *config_file, init_data *bounds, int verbose, const char **error) {
+	// Map the configuration file, or read it in if it can't be mapped.
+	int fd = open(config_file, O_RDONLY);
+	if (fd < 0) {
+		*error = "could not be opened";
+		return NULL;
+	}
+	struct stat info;
+	size_t size = 0;
+	char *text = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+		size = info.st_size;
+		text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	int mapped = text != MAP_FAILED;
+	if (!mapped) { text = readFile(fd, &size); }
+	close(fd);
+	const char *pos = text;
+	const char *end = text + size;
+	// RLE files start with # comments or their x = header.
+	while (pos < end && (*pos == ' ' || (*pos >= '\t' && *pos <= '\r'))) { ++pos; }
+	if (pos < end && (*pos == '#' || *pos == 'x')) {
+		Board *earth = readRle(pos, end, bounds, error);
+		if (verbose && earth != NULL) {
+			printf("number of rows %d\n", bounds->num_rows);
+			printf("number of columns %d\n", bounds->num_cols);
+			printf("number of live cells %d\n", bounds->init_pairs);
+		}
+		if (mapped) { munmap(text, size); }
+		else { free(text); }
+		return earth;
+	}
+	// Read the game specifications. Give an error message if values are not
+	// appropriate.
+	long long num_rows = 0, num_cols = 0, init_pairs = 0;
+	if (!scanInt(&pos, end, &num_rows)) { printf("ERROR\n"); }
+	if (!scanInt(&pos, end, &num_cols)) { printf("ERROR\n"); }
+	if (!scanInt(&pos, end, &bounds->iterations)) { printf("ERROR\n"); }
+	if (!scanInt(&pos, end, &init_pairs)) { printf("ERROR\n"); }
+	// Sizes are checked before they are narrowed to an int.
+	if (num_rows < 1 || num_cols < 1 || num_rows > MAX_BOARD_SIDE || num_cols > MAX_BOARD_SIDE
+			|| init_pairs > INT_MAX) {
+		*error = init_pairs > INT_MAX ? "invalid number of initial pairs" : "invalid board size";
+		if (mapped) { munmap(text, size); }
+		else { free(text); }
+		return NULL;
+	}
+	bounds->num_rows = num_rows;
+	bounds->num_cols = num_cols;
+	bounds->init_pairs = init_pairs;
+	// The project's config format has no rule; it is always Conway's Life.
+	parseRule("B3/S23", &bounds->rule);
+	// Print if in verbose mode.
+	if (verbose) {
+		printf("number of rows %d\n", bounds->num_rows);
+		printf("number of columns %d\n", bounds->num_cols);
+		printf("number of iterations %lld\n", bounds->iterations);
+		printf("number of initial pairs %d\n", bounds->init_pairs);
+	}
+	// Allocate memory for the game board. Every cell starts out dead.
+	Board *earth = boardAlloc(bounds->num_rows, bounds->num_cols);
+	// Read the cells that start alive.
+	parseCells(earth, pos, end);
+	// Fill in the halo ring for the first generation.
+	refreshHalo(earth, 0, earth->num_rows - 1);
+	// Unmap or free the file and return the pointer to the game board.
+	if (mapped) { munmap(text, size); }
+	else { free(text); }
+	return earth;
+}
+
+/**
+ *
+ * readRle
+ *
+ * Reads a pattern in the RLE format: # comment lines, a header like
+ * "x = 3, y = 3, rule = B3/S23", then runs of dead (b) and live (o, or any
+ * other letter) cells, with $ ending a row and ! the pattern, each run
+ * led by an optional count. The board is x by y, unless the rule ends in a
+ * torus like ":T100,80", which sets the size, with the pattern centered
+ * on it. Runs are written straight into the board. RLE has no iteration
+ * count, so it is 0 until -i gives one.
+ *
+ * @param text; the start of the file.
+ * @param end; one past the last character of the file.
+ * @param bounds; set to the board's size, iterations, live cells and rule.
+ * @param error; set to the reason when the pattern can't be read.
+ * @return earth; a pointer to the bit-packed game board, or NULL.
+ **/
+Board *readRle(const char *text, const char *end, init_data *bounds, const char **error) {
+	// Skip the comments.
+	const char *pos = text;
+	while (pos < end && *pos == '#') {
+		pos = memchr(pos, '\n', end - pos);
+		pos = pos != NULL ? pos + 1 : end;
+		while (pos < end && (*pos == ' ' || (*pos >= '\t' && *pos <= '\r'))) { ++pos; }
+	}
+
+	// The header: comma separated key = value pairs, the rule last since a
+	// torus size has a comma of its own.
+	const char *line_end = pos < end ? memchr(pos, '\n', end - pos) : NULL;
+	if (line_end == NULL) { line_end = end; }
+	long long width = -1;
+	long long height = -1;
+	char rule_text[64] = "B3/S23";
+	while (pos < line_end) {
+		while (pos < line_end && (*pos == ' ' || *pos == ',' || *pos == '\t' || *pos == '\r')) { ++pos; }
+		const char *key = pos;
+		while (pos < line_end && *pos != '=' && *pos != ' ') { ++pos; }
+		size_t key_len = pos - key;
+		while (pos < line_end && (*pos == ' ' || *pos == '=')) { ++pos; }
+		const char *value = pos;
+		if (key_len == 4 && strncmp(key, "rule", 4) == 0) {
+			size_t len = line_end - value;
+			while (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\r')) { --len; }
+			if (len >= sizeof(rule_text)) { len = sizeof(rule_text) - 1; }
+			memcpy(rule_text, value, len);
+			rule_text[len] = '\0';
+			pos = line_end;
+		}
+		else if (key_len == 1 && *key == 'x') { scanInt(&pos, line_end, &width); }
+		else if (key_len == 1 && *key == 'y') { scanInt(&pos, line_end, &height); }
+		while (pos < line_end && *pos != ',') { ++pos; }
+	}
+	if (width < 1 || height < 1) {
+		*error = "RLE header needs x and y";
+		return NULL;
+	}
+
+	// A bounded grid follows the rule after a colon; only a torus fits.
+	long long cols = width;
+	long long rows = height;
+	char *grid = strchr(rule_text, ':');
+	if (grid != NULL) {
+		*grid++ = '\0';
+		const char *size_pos = grid + 1;
+		const char *size_end = grid + strlen(grid);
+		if (*grid != 'T' || !scanInt(&size_pos, size_end, &cols) || *size_pos++ != ','
+				|| !scanInt(&size_pos, size_end, &rows) || cols < width || rows < height) {
+			*error = "RLE grid is not a torus the pattern fits on";
+			return NULL;
+		}
+	}
+	if (cols > MAX_BOARD_SIDE || rows > MAX_BOARD_SIDE) {
+		*error = "invalid board size";
+		return NULL;
+	}
+	bounds->num_cols = cols;
+	bounds->num_rows = rows;
+	if (!parseRule(rule_text, &bounds->rule)) {
+		*error = "could not parse the RLE rule";
+		return NULL;
+	}
+	bounds->iterations = 0;
+	Board *earth = boardAlloc(bounds->num_rows, bounds->num_cols);
+	int row_offset = (bounds->num_rows - height) / 2;
+	int col_offset = (bounds->num_cols - width) / 2;
+
+	// The runs.
+	long long row = 0;
+	long long col = 0;
+	long long count = 0;
+	for (pos = line_end; pos < end; ++pos) {
+		char c = *pos;
+		if (c >= '0' && c <= '9') {
+			if (count < INT_MAX) { count = count * 10 + (c - '0'); }
+			continue;
+		}
+		if (c == '!') { break; }
+		if (c == ' ' || (c >= '\t' && c <= '\r')) { continue; }
+		long long run = count > 0 ? count : 1;
+		count = 0;
+		if (c == '$') {
+			row += run;
+			col = 0;
+		}
+		else if (c == 'b' || c == '.') {
+			col += run;
+		}
+		else {
+			if (row >= height || col + run > width) {
+				printf("ERROR: RLE run at (%lld, %lld) is off the board\n", col, row);
+			}
+			else {
+				setRun(earth, row_offset + row, col_offset + col, run);
+			}
+			col += run;
+		}
+	}
+	refreshHalo(earth, 0, earth->num_rows - 1);
+	bounds->init_pairs = boardPopulation(earth);
+	return earth;
+}
+
+/**
+ *
+ * writeRle
+ *
+ * Writes the board to a file in the RLE format readRle takes, as a torus
+ * the size of the board, so it reads back exactly. Dead cells at the end of
+ * a row and empty rows at the end are left out, runs are found a word at a
+ * time, and lines are kept to 70 characters.
+ *
+ * @param earth; the board.
+ * @param rule; the rule to record in the header.
+ * @param rle_file; the file to write.
+ * @return void.
+ **/
+void writeRle(const Board *earth, Rule rule, const char *rle_file) {
+	FILE *file = fopen(rle_file, "w");
+	if (file == NULL) {
+		printf("ERROR: could not write %s\n", rle_file);
+		return;
+	}
+	char rule_text[32];
+	ruleText(rule, rule_text);
+	fprintf(file, "x = %d, y = %d, rule = %s:T%d,%d\n", earth->num_cols, earth->num_rows,
+			rule_text, earth->num_cols, earth->num_rows);
+
+	int line_len = 0;
+	long long rows_ended = 0;
+	for (int row = 0; row < earth->num_rows; ++row) {
+		const uint64_t *cells = earth->cells + (ptrdiff_t)row * earth->row_pitch;
+		int dead = 0;
+		for (int col = 0; col < earth->num_cols; ) {
+			int alive = (cells[col / WORD_BITS] >> (col & (WORD_BITS - 1))) & 1;
+			int stop = runEnd(cells, col, earth->num_cols, alive);
+			if (!alive) { dead = stop - col; }
+			else {
+				// Runs for the rows ended since the last live cell, the dead
+				// cells before this run, then the run.
+				long long runs[3] = { rows_ended, dead, stop - col };
+				const char tags[3] = { '$', 'b', 'o' };
+				for (int r = 0; r < 3; ++r) {
+					if (runs[r] == 0) { continue; }
+					char run[24];
+					int len = runs[r] > 1 ? snprintf(run, sizeof(run), "%lld%c", runs[r], tags[r])
+						: snprintf(run, sizeof(run), "%c", tags[r]);
+					if (line_len + len > 70) {
+						fputc('\n', file);
+						line_len = 0;
+					}
+					fputs(run, file);
+					line_len += len;
+				}
+				rows_ended = 0;
+				dead = 0;
+			}
+			col = stop;
+		}
+		++rows_ended;
+	}
+	fputs("!\n", file);
+	fclose(file);
+}
+
+/**
+ * Writes the rule into text in B/S notation, e.g. "B3/S23"; text needs
+ * room for 22 characters.
+ **/
+void ruleText(Rule rule, char *text) {
+	*text++ = 'B';
+	for (int n = 0; n <= 8; ++n) {
+		if ((rule.birth >> n) & 1) { *text++ = '0' + n; }
+	}
+	*text++ = '/';
+	*text++ = 'S';
+	for (int n = 0; n <= 8; ++n) {
+		if ((rule.survive >> n) & 1) { *text++ = '0' + n; }
+	}
+	*text = '\0';
+}
+
+/**
+ * Reads everything left in fd into a buffer the caller frees, for files
+ * that can't be mapped, and sets size to its length.
+ **/
+char *readFile(int fd, size_t *size) {
+	size_t capacity = 1 << 16;
+	char *text = malloc(capacity);
+	*size = 0;
+	for (;;) {
+		if (text == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		ssize_t n = read(fd, text + *size, capacity - *size);
+		if (n < 0 && errno == EINTR) { continue; }
+		if (n <= 0) { break; }
+		*size += n;
+		if (*size == capacity) {
+			capacity *= 2;
+			text = realloc(text, capacity);
+		}
+	}
+	return text;
+}
+
+/**
+ *
+ * parseCells
+ *
+ * Sets the cells a config file lists as "col row" pairs alive, stopping at
+ * the end of the text or at anything that is not an integer. A big file
+ * is cut at newlines into chunks parsed on threads of their own. The
+ * chunks are first counted, so each one knows whether it starts halfway
+ * through a pair, and the pairs that straddle two chunks are set here.
+ *
+ * @param earth; the board, with every cell dead.
+ * @param text; the first character after the header.
+ * @param end; one past the last character of the file.
+ * @return void.
+ **/
+void parseCells(Board *earth, const char *text, const char *end) {
+	size_t bytes = end - text;
+	long num_chunks = bytes / PARSE_CHUNK_BYTES;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_chunks > cpus) { num_chunks = cpus; }
+	if (num_chunks > PARSE_MAX_THREADS) { num_chunks = PARSE_MAX_THREADS; }
+
+	// A small file is parsed right here, in one pass.
+	if (num_chunks <= 1) {
+		ParseChunk chunk = { .start = text, .end = end, .earth = earth, .pass = 1 };
+		parseChunk(&chunk);
+		return;
+	}
+
+	ParseChunk chunks[PARSE_MAX_THREADS];
+	pthread_t threads[PARSE_MAX_THREADS];
+	const char *start = text;
+	for (int k = 0; k < num_chunks; ++k) {
+		const char *cut = k == num_chunks - 1 ? end : text + bytes / num_chunks * (k + 1);
+		if (cut < start) { cut = start; }
+		if (cut < end) {
+			const char *newline = memchr(cut, '\n', end - cut);
+			cut = newline != NULL ? newline + 1 : end;
+		}
+		memset(&chunks[k], 0, sizeof(ParseChunk));
+		chunks[k].start = start;
+		chunks[k].end = cut;
+		chunks[k].earth = earth;
+		chunks[k].shared = 1;
+		start = cut;
+	}
+	for (int k = 0; k < num_chunks; ++k) {
+		pthread_create(&threads[k], NULL, parseChunk, &chunks[k]);
+	}
+	for (int k = 0; k < num_chunks; ++k) {
+		pthread_join(threads[k], NULL);
+	}
+
+	// Nothing after the first thing that isn't an integer counts. Each
+	// chunk that starts halfway through a pair finishes it here.
+	long long parity = 0;
+	long long col = 0;
+	for (int k = 0; k < num_chunks; ++k) {
+		chunks[k].pass = 1;
+		if (chunks[k].count > 0 && parity & 1) {
+			placeCell(earth, col, chunks[k].first, 0);
+			chunks[k].skip_first = 1;
+		}
+		if (chunks[k].count > 0) { col = chunks[k].last; }
+		parity += chunks[k].count;
+		if (chunks[k].stop < chunks[k].end) {
+			chunks[k].end = chunks[k].stop;
+			for (int rest = k + 1; rest < num_chunks; ++rest) { chunks[rest].start = chunks[rest].end; }
+			break;
+		}
+	}
+	for (int k = 0; k < num_chunks; ++k) {
+		pthread_create(&threads[k], NULL, parseChunk, &chunks[k]);
+	}
+	for (int k = 0; k < num_chunks; ++k) {
+		pthread_join(threads[k], NULL);
+	}
+}
+
+/**
+ *
+ * parseChunk
+ *
+ * Runs one pass over a chunk of a config file: counting its integers, or
+ * setting the cells its whole pairs name. Other chunks may be setting
+ * cells in the same words in the second pass, unless this is the only one.
+ *
+ * @param args; the chunk.
+ * @return NULL.
+ **/
+void *parseChunk(void *args) {
+	ParseChunk *chunk = (ParseChunk*)args;
+	const char *pos = chunk->start;
+	long long value;
+	if (chunk->pass == 0) {
+		while (scanInt(&pos, chunk->end, &value)) {
+			if (chunk->count++ == 0) { chunk->first = value; }
+			chunk->last = value;
+		}
+		chunk->stop = pos;
+		return NULL;
+	}
+	long long col, row;
+	if (chunk->skip_first) { scanInt(&pos, chunk->end, &value); }
+	while (scanInt(&pos, chunk->end, &col) && scanInt(&pos, chunk->end, &row)) {
+		placeCell(chunk->earth, col, row, chunk->shared);
+	}
+	return NULL;
+}
+
+/**
+ *
+ * boardAlloc
+ *
+ * Allocates a bit-packed board with every cell dead, including the halo
+ * ring around it. Rows are padded to a whole number of 64-bit words; apart
+ * from the halo column, the padding bits are always kept at 0.
+ *
+ * @param num_rows; the number of rows on the board.
+ * @param num_cols; the number of columns on the board.
+ * @return board; a pointer to the newly allocated board.
+ **/
+Board *boardAlloc(int num_rows, int num_cols) {
+	if (num_rows < 1 || num_cols < 1 || num_rows > MAX_BOARD_SIDE || num_cols > MAX_BOARD_SIDE) {
+		printf("ERROR: invalid board size %d x %d\n", num_rows, num_cols);
+		exit(1);
+	}
+	Board *board = malloc(sizeof(Board));
+	if (board == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	board->num_rows = num_rows;
+	board->num_cols = num_cols;
+	board->row_words = (num_cols + WORD_BITS - 1) / WORD_BITS;
+	// One halo word in front of each row and one after it.
+	board->row_pitch = board->row_words + 2;
+	// calloc hands back zeroed pages, which is exactly an empty board. Two
+	// extra rows hold the top and bottom halo.
+	board->base = calloc((size_t)(num_rows + 2) * board->row_pitch, sizeof(uint64_t));
+	if (board->base == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	board->cells = board->base + board->row_pitch + 1;
+	return board;
+}
+
+/**
+ *
+ * boardFree
+ *
+ * Releases a board allocated by boardAlloc.
+ *
+ * @param board; a pointer to the board to free.
+ * @return void.
+ **/
+void boardFree(Board *board) {
+	if (board == NULL) { return; }
+	free(board->base);
+	free(board);
+}
+
+/**
+ *
+ * refreshHalo
+ *
+ * Copies the opposite edges of the torus into the halo ring for rows
+ * row_start..row_end: columns -2 and -1 get the last two columns and
+ * columns num_cols and num_cols + 1 get the first two. Whoever owns row 0 or
+ * the last row also copies it, halo columns included, into the halo row on
+ * the other side of the board. The cost is O(perimeter) per generation, and
+ * the step kernels never have to wrap an index.
+ *
+ * @param board; a pointer to the board.
+ * @param row_start; the first row to refresh.
+ * @param row_end; the last row to refresh (inclusive).
+ * @return void.
+ **/
+void refreshHalo(Board *board, int row_start, int row_end) {
+	int num_cols = board->num_cols;
+	// Wrapped sources; on a one column board they are all column 0.
+	int second = 1 % num_cols;
+	int second_last = (num_cols - 2 + num_cols) % num_cols;
+	size_t row_bytes = board->row_pitch * sizeof(uint64_t);
+	for (int row = row_start; row <= row_end; ++row) {
+		int first_cells = getCell(board, row, 0) | getCell(board, row, second) << 1;
+		int last_cells = getCell(board, row, second_last) | getCell(board, row, num_cols - 1) << 1;
+		setCell(board, row, -2, last_cells & 1);
+		setCell(board, row, -1, last_cells >> 1);
+		setCell(board, row, num_cols, first_cells & 1);
+		setCell(board, row, num_cols + 1, first_cells >> 1);
+	}
+	if (row_start == 0) {
+		memcpy(cellWord(board, board->num_rows, -1), cellWord(board, 0, -1), row_bytes);
+	}
+	if (row_end == board->num_rows - 1) {
+		memcpy(cellWord(board, -1, -1), cellWord(board, board->num_rows - 1, -1), row_bytes);
+	}
+}
+
+/**
+ * Returns the next generation of the cell at (row, col), straight from the
+ * rule.
+ **/
+static int stepCell(const Board *cur, int row, int col, Rule rule) {
+	int count = neighbors((Board *)cur, row, col);
+	uint16_t counts = getCell(cur, row, col) ? rule.survive : rule.birth;
+	return (counts >> count) & 1;
+}
+
+/**
+ *
+ * refreshBlockHalo
+ *
+ * refreshHalo for a block that covers only some of the words of its rows.
+ * The halo columns on either side of the board come from the first and last
+ * two columns, which another thread may still be computing, so the block
+ * that owns the first word works out the last two columns' next generation
+ * for itself from the current board, and the block that owns the last word
+ * does the same for the first two. Each only ever writes its own words (the
+ * word in front of the row counts as the first block's, the halo bits past
+ * the last column as the last block's), and copies just those into the
+ * halo row on the other side of the board. A block as wide as the board
+ * falls through to refreshHalo.
+ *
+ * @param cur; the board holding the current generation.
+ * @param next; the board holding the block's next generation.
+ * @param row_start; the block's first row.
+ * @param row_end; the block's last row (inclusive).
+ * @param word_start; the block's first word.
+ * @param word_end; one past the block's last word.
+ * @param rule; the rule to apply.
+ * @return void.
+ **/
+void refreshBlockHalo(const Board *cur, Board *next, int row_start, int row_end,
+		int word_start, int word_end, Rule rule) {
+	if (word_start == 0 && word_end == next->row_words) {
+		refreshHalo(next, row_start, row_end);
+		return;
+	}
+	int num_cols = next->num_cols;
+	int second = 1 % num_cols;
+	int second_last = (num_cols - 2 + num_cols) % num_cols;
+	for (int row = row_start; row <= row_end; ++row) {
+		if (word_start == 0) {
+			setCell(next, row, -2, stepCell(cur, row, second_last, rule));
+			setCell(next, row, -1, stepCell(cur, row, num_cols - 1, rule));
+		}
+		if (word_end == next->row_words) {
+			setCell(next, row, num_cols, stepCell(cur, row, 0, rule));
+			setCell(next, row, num_cols + 1, stepCell(cur, row, second, rule));
+		}
+	}
+
+	// The words to copy into the halo rows, with the halo words at either
+	// end of the row for the blocks that own them.
+	int first = word_start == 0 ? -1 : word_start;
+	int last = word_end == next->row_words ? next->row_words : word_end - 1;
+	size_t bytes = (size_t)(last - first + 1) * sizeof(uint64_t);
+	if (row_start == 0) {
+		memcpy(next->cells + (ptrdiff_t)next->num_rows * next->row_pitch + first,
+				next->cells + first, bytes);
+	}
+	if (row_end == next->num_rows - 1) {
+		memcpy(next->cells - next->row_pitch + first,
+				next->cells + (ptrdiff_t)(next->num_rows - 1) * next->row_pitch + first, bytes);
+	}
+}
+
+/**
+ *
+ * copyRegion
+ *
+ * Copies a block of one board into another board of the same size, along
+ * with the halo words and rows next to it on the edges of the board.
+ *
+ * @param src; the board to copy from.
+ * @param dst; the board to copy into.
+ * @param row_start; the block's first row.
+ * @param row_end; the block's last row (inclusive).
+ * @param word_start; the block's first word.
+ * @param word_end; one past the block's last word.
+ * @return void.
+ **/
+void copyRegion(const Board *src, Board *dst, int row_start, int row_end,
+		int word_start, int word_end) {
+	int first = word_start == 0 ? -1 : word_start;
+	int last = word_end == dst->row_words ? dst->row_words : word_end - 1;
+	// Halo row -1 sits in front of row 0 and halo row num_rows after the
+	// last one.
+	if (row_start == 0) { --row_start; }
+	if (row_end == dst->num_rows - 1) { ++row_end; }
+	size_t bytes = (size_t)(last - first + 1) * sizeof(uint64_t);
+	for (int row = row_start; row <= row_end; ++row) {
+		memcpy(dst->cells + (ptrdiff_t)row * dst->row_pitch + first,
+				src->cells + (ptrdiff_t)row * src->row_pitch + first, bytes);
+	}
+}
+
+/**
+ *
+ * regionNode
+ *
+ * Asks the kernel which NUMA node holds a block of the board, going by a
+ * sample of up to NODE_SAMPLES of its rows.
+ *
+ * @param board; the board.
+ * @param row_start; the block's first row.
+ * @param row_end; the block's last row (inclusive).
+ * @param word_start; the block's first word.
+ * @param word_end; one past the block's last word.
+ * @return the node holding most of the sampled pages, or -1 if the kernel
+ * 		can't tell.
+ **/
+int regionNode(const Board *board, int row_start, int row_end, int word_start, int word_end) {
+	int rows = row_end - row_start + 1;
+	if (rows < 1 || word_end <= word_start) { return -1; }
+	int count = rows < NODE_SAMPLES ? rows : NODE_SAMPLES;
+	uintptr_t page_mask = ~(uintptr_t)(sysconf(_SC_PAGESIZE) - 1);
+	void *pages[NODE_SAMPLES];
+	int status[NODE_SAMPLES];
+	for (int k = 0; k < count; ++k) {
+		int row = row_start + (int)((long long)k * rows / count);
+		pages[k] = (void*)((uintptr_t)(board->cells + (ptrdiff_t)row * board->row_pitch
+					+ word_start) & page_mask);
+	}
+	// With no target nodes, move_pages only reports where each page is.
+	if (syscall(SYS_move_pages, 0, (unsigned long)count, pages, NULL, status, 0) != 0) {
+		return -1;
+	}
+	int votes[MAX_NODES] = {0};
+	int best = -1;
+	for (int k = 0; k < count; ++k) {
+		if (status[k] < 0 || status[k] >= MAX_NODES) { continue; }
+		++votes[status[k]];
+		if (best < 0 || votes[status[k]] > votes[best]) { best = status[k]; }
+	}
+	return best;
+}
+
+/**
+ *
+ * pickGrid
+ *
+ * Picks the grid of blocks num_threads threads split the board into: the
+ * grid_rows x grid_cols = num_threads layout whose blocks have the
+ * shortest edges, and so the least halo per thread. A board can't be cut
+ * into more block rows than it has rows, or more block columns than
+ * max_cols; when no layout for num_threads fits, the grid is the one for
+ * the most threads that does, and the rest are left out.
+ *
+ * @param num_threads; the number of threads.
+ * @param num_rows; the number of rows on the board.
+ * @param num_cols; the number of columns on the board.
+ * @param max_cols; the most block columns allowed.
+ * @param grid_rows; set to the number of block rows.
+ * @param grid_cols; set to the number of block columns.
+ * @return void.
+ **/
+void pickGrid(int num_threads, int num_rows, int num_cols, int max_cols,
+		int *grid_rows, int *grid_cols) {
+	*grid_rows = 0;
+	*grid_cols = 0;
+	long long best = 0;
+	for (int used = num_threads; used > 0 && *grid_rows == 0; --used) {
+		for (int q = 1; q <= used && q <= max_cols; ++q) {
+			if (used % q) { continue; }
+			int p = used / q;
+			if (p > num_rows) { continue; }
+			// Half the perimeter of the largest block.
+			long long edges = (num_rows + p - 1) / p + (long long)(num_cols + q - 1) / q;
+			if (*grid_rows == 0 || edges < best) {
+				best = edges;
+				*grid_rows = p;
+				*grid_cols = q;
+			}
+		}
+	}
+}
+
+/**
+ *
+ * byteBoardAlloc
+ *
+ * Allocates a byte-per-cell board with every cell dead, including the halo
+ * ring around it.
+ *
+ * @param num_rows; the number of rows on the board.
+ * @param num_cols; the number of columns on the board.
+ * @return board; a pointer to the newly allocated board.
+ **/
+ByteBoard *byteBoardAlloc(int num_rows, int num_cols) {
+	ByteBoard *board = malloc(sizeof(ByteBoard));
+	if (board == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	board->num_rows = num_rows;
+	board->num_cols = num_cols;
+	board->row_pitch = num_cols + 2;
+	board->base = calloc((size_t)(num_rows + 2) * board->row_pitch, 1);
+	if (board->base == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	board->cells = board->base + board->row_pitch + 1;
+	return board;
+}
+
+/**
+ *
+ * byteBoardFree
+ *
+ * Releases a board allocated by byteBoardAlloc.
+ *
+ * @param board; a pointer to the board to free.
+ * @return void.
+ **/
+void byteBoardFree(ByteBoard *board) {
+	if (board == NULL) { return; }
+	free(board->base);
+	free(board);
+}
+
+/**
+ *
+ * refreshByteHalo
+ *
+ * The byte-per-cell version of refreshHalo.
+ *
+ * @param board; a pointer to the board.
+ * @param row_start; the first row to refresh.
+ * @param row_end; the last row to refresh (inclusive).
+ * @return void.
+ **/
+void refreshByteHalo(ByteBoard *board, int row_start, int row_end) {
+	int num_cols = board->num_cols;
+	for (int row = row_start; row <= row_end; ++row) {
+		uint8_t *cells = board->cells + (ptrdiff_t)row * board->row_pitch;
+		cells[-1] = cells[num_cols - 1];
+		cells[num_cols] = cells[0];
+	}
+	if (row_start == 0) {
+		memcpy(board->cells + (ptrdiff_t)board->num_rows * board->row_pitch - 1,
+				board->cells - 1, board->row_pitch);
+	}
+	if (row_end == board->num_rows - 1) {
+		memcpy(board->cells - board->row_pitch - 1,
+				board->cells + (ptrdiff_t)(board->num_rows - 1) * board->row_pitch - 1,
+				board->row_pitch);
+	}
+}
+
+/**
+ *
+ * unpackBoard
+ *
+ * Copies rows row_start..row_end of a bit-packed board into a byte-per-cell
+ * board.
+ *
+ * @param board; the bit-packed board to read.
+ * @param bytes; the byte-per-cell board to write.
+ * @param row_start; the first row to copy.
+ * @param row_end; the last row to copy (inclusive).
+ * @return void.
+ **/
+void unpackBoard(const Board *board, ByteBoard *bytes, int row_start, int row_end) {
+	for (int row = row_start; row <= row_end; ++row) {
+		uint8_t *cells = bytes->cells + (ptrdiff_t)row * bytes->row_pitch;
+		for (int col = 0; col < board->num_cols; ++col) {
+			cells[col] = getCell(board, row, col);
+		}
+	}
+}
+
+/**
+ *
+ * packBoard
+ *
+ * Copies rows row_start..row_end of a byte-per-cell board back into a
+ * bit-packed board, halo included.
+ *
+ * @param bytes; the byte-per-cell board to read.
+ * @param board; the bit-packed board to write.
+ * @param row_start; the first row to copy.
+ * @param row_end; the last row to copy (inclusive).
+ * @return void.
+ **/
+void packBoard(const ByteBoard *bytes, Board *board, int row_start, int row_end) {
+	for (int row = row_start; row <= row_end; ++row) {
+		const uint8_t *cells = bytes->cells + (ptrdiff_t)row * bytes->row_pitch;
+		for (int col = 0; col < board->num_cols; ++col) {
+			setCell(board, row, col, cells[col]);
+		}
+	}
+	refreshHalo(board, row_start, row_end);
+}
+
+/**
+ *
+ * printEarth
+ *
+ * Print's the board out as a N x N torus
+ *
+ * @param earth; a pointer to the game board. 
+ * @param iteration; the iteration that was just simulated.
+ * @return void. 
+ **/
+void printEarth(Board *earth, long long iteration) {
+	// Local variables
+	int i = 0;
+	int j = 0;
+	printf("DAY %lld\n==================\n", iteration + 1);
+	// Print variables out row by row.
+	for (i = 0; i < earth->num_rows; ++i) {
+		// Print out each element in the curent column.
+		for (j = 0; j < earth->num_cols; ++j) {
+			printf("%c ", getCell(earth, i, j) ? '@' : '-');
+		}
+		// Print next row underneath previous row.
+		printf("\n");
+	}
+	usleep(DELAY);
+}
+
+/**
+ *
+ * simulateLife
+ *
+ * Simulates the game of life for one iteration over this thread's rows (two
+ * for the lut2 engine, up to time_block with temporal blocking); determine's
+ * which cells live or die based on # of neighbors in the front board and
+ * writes the result into the back board. The caller waits on the barrier and
+ * swaps the boards once every thread is done.
+ *
+ * @param thread_data; a pointer to a struct holding all the necessary data. 
+ * @param generation; the number of iterations simulated so far.
+ * @param remaining; the number of iterations left to simulate.
+ * @return the number of iterations simulated.
+ **/
+int simulateLife(Threads *thread_data, long long generation, long long remaining){
+
+	Board *earth = thread_data->earth;
+	Board *next = thread_data->next;
+	Rule rule = thread_data->bounds->rule;
+
+	// The column-sum engine works on its own byte-per-cell boards.
+	if (thread_data->engine == ENGINE_COLSUM) {
+		stepColumnSums(thread_data->bytes, thread_data->next_bytes, thread_data->col_sums,
+				thread_data->row_start, thread_data->row_end, rule);
+		refreshByteHalo(thread_data->next_bytes, thread_data->row_start, thread_data->row_end);
+		return 1;
+	}
+
+	// Temporal blocking runs several generations on the thread's own copy.
+	if (thread_data->time_block > 1) {
+		return stepTimeBlock(thread_data, remaining);
+	}
+
+	// The lookup table engines; lut2 jumps two generations when it can.
+	if (thread_data->engine == ENGINE_LUT || thread_data->engine == ENGINE_LUT2) {
+		int generations = 1;
+		if (thread_data->engine == ENGINE_LUT2 && remaining >= 2) {
+			stepLookupRows2(earth, next, thread_data->life_table,
+					thread_data->row_start, thread_data->row_end);
+			generations = 2;
+		}
+		else {
+			stepLookupRows(earth, next, thread_data->life_table, thread_data->row_start,
+					thread_data->row_end, thread_data->word_start, thread_data->word_end);
+		}
+		refreshBlockHalo(earth, next, thread_data->row_start, thread_data->row_end,
+				thread_data->word_start, thread_data->word_end, rule);
+		return generations;
+	}
+
+	// The word-parallel engines handle a whole word of cells at a time,
+	// skipping the quiet parts of the board when tiles are tracked.
+	if (thread_data->engine != ENGINE_SCALAR) {
+		if (thread_data->tiles != NULL) {
+			stepBitTiles(thread_data, generation,
+					thread_data->history != NULL ? &thread_data->hash_delta : NULL);
+		}
+		else {
+			stepBitBlock(earth, next, thread_data->row_start, thread_data->row_end,
+					thread_data->word_start, thread_data->word_end, thread_data->engine, rule);
+		}
+		refreshBlockHalo(earth, next, thread_data->row_start, thread_data->row_end,
+				thread_data->word_start, thread_data->word_end, rule);
+		return 1;
+	}
+
+	// Walk through this thread's block of the earth.
+	int col_start = thread_data->word_start * WORD_BITS;
+	int col_end = thread_data->word_end * WORD_BITS;
+	if (col_end > earth->num_cols) { col_end = earth->num_cols; }
+	for (int row = thread_data->row_start; row <= thread_data->row_end; ++row) {
+		for (int col = col_start; col < col_end; ++col) {
+			int count = neighbors(earth, row, col);
+
+			// If alive; the rule says whether it survives with this many
+			// neighbors. If dead; whether it is born.
+			if (getCell(earth, row, col)) {
+				setCell(next, row, col, (rule.survive >> count) & 1);
+			}
+			else {
+				setCell(next, row, col, (rule.birth >> count) & 1);
+			}
+		}
+	}
+	refreshBlockHalo(earth, next, thread_data->row_start, thread_data->row_end,
+			thread_data->word_start, thread_data->word_end, rule);
+	return 1;
+}
+
+/**
+ *
+ * stepRows
+ *
+ * Runs simulateLife over the thread's current rows and, when looking for
+ * cycles, folds the change those rows made into the thread's share of the
+ * board hash (the tiles do that as they go).
+ *
+ * @param thread_data; the thread, with row_start and row_end set.
+ * @param generation; the number of iterations simulated so far.
+ * @param remaining; the number of iterations left to simulate.
+ * @return the number of iterations simulated.
+ **/
+int stepRows(Threads *thread_data, long long generation, long long remaining) {
+	int generations = simulateLife(thread_data, generation, remaining);
+	if (thread_data->history != NULL && thread_data->tiles == NULL) {
+		blockChanged(thread_data->earth, thread_data->next, thread_data->row_start,
+				thread_data->row_end, thread_data->word_start, thread_data->word_end,
+				&thread_data->hash_delta);
+	}
+	return generations;
+}
+
+/**
+ *
+ * stepBands
+ *
+ * Runs one generation (two for lut2) under the work-stealing scheduler.
+ * The thread queues up its own bands, works through them, then steals
+ * what is left in the other threads' deques until they are all empty.
+ * Every band is stepped exactly once, and the barrier in threadFunc still
+ * ends the generation.
+ *
+ * @param thread_data; the thread.
+ * @param generation; the number of iterations simulated so far.
+ * @param remaining; the number of iterations left to simulate.
+ * @return the number of iterations simulated.
+ **/
+int stepBands(Threads *thread_data, long long generation, long long remaining) {
+	Scheduler *scheduler = thread_data->scheduler;
+	BandDeque *own = &scheduler->deques[thread_data->tid];
+	int num_rows = thread_data->earth->num_rows;
+	int row_start = thread_data->row_start;
+	int row_end = thread_data->row_end;
+	// Every band of a generation advances by the same amount.
+	int generations = remaining >= 2 && thread_data->engine == ENGINE_LUT2 ? 2 : 1;
+
+	// Queue the last band first, so the owner works down from its first
+	// band while thieves take from the far end.
+	for (int band = thread_data->band_end - 1; band >= thread_data->band_start; --band) {
+		dequePush(own, band);
+	}
+
+	for (int n = 0; n < scheduler->num_threads; ++n) {
+		BandDeque *deque = &scheduler->deques[(thread_data->tid + n) % scheduler->num_threads];
+		for (;;) {
+			int band = n == 0 ? dequeTake(deque) : dequeSteal(deque);
+			if (band == DEQUE_EMPTY) { break; }
+			// Lost a race with another thief; try again.
+			if (band == DEQUE_ABORT) { continue; }
+			thread_data->row_start = band * scheduler->band_rows;
+			thread_data->row_end = thread_data->row_start + scheduler->band_rows - 1;
+			if (thread_data->row_end >= num_rows) { thread_data->row_end = num_rows - 1; }
+			stepRows(thread_data, generation, remaining);
+			++thread_data->bands_done;
+			if (n != 0) { ++thread_data->bands_stolen; }
+		}
+	}
+
+	thread_data->row_start = row_start;
+	thread_data->row_end = row_end;
+	return generations;
+}
+
+/**
+ *
+ * homeRegion
+ *
+ * Finds the block of the board a thread owns: its strip or block under
+ * static partitioning, or the rows of the bands it starts each generation
+ * with when they are stolen.
+ *
+ * @param thread_data; the thread.
+ * @param row_start; set to the first row.
+ * @param row_end; set to the last row (inclusive); less than row_start if
+ * 		the thread has no rows.
+ * @param word_start; set to the first word.
+ * @param word_end; set to one past the last word.
+ * @return void.
+ **/
+void homeRegion(const Threads *thread_data, int *row_start, int *row_end,
+		int *word_start, int *word_end) {
+	*row_start = thread_data->row_start;
+	*row_end = thread_data->row_end;
+	*word_start = thread_data->word_start;
+	*word_end = thread_data->word_end;
+	if (thread_data->scheduler != NULL) {
+		int band_rows = thread_data->scheduler->band_rows;
+		*row_start = thread_data->band_start * band_rows;
+		*row_end = thread_data->band_end * band_rows - 1;
+		if (*row_end >= thread_data->earth->num_rows) { *row_end = thread_data->earth->num_rows - 1; }
+	}
+}
+
+/**
+ *
+ * firstTouch
+ *
+ * Copies the thread's own rows of the loaded board into the front and back
+ * boards, which nothing has written yet, so their pages are placed on the
+ * thread's NUMA node. The back board gets a copy too, since tiles that are
+ * skipped keep what it held. The column-sum engine's byte boards are filled
+ * the same way.
+ *
+ * @param thread_data; the thread.
+ * @return void.
+ **/
+void firstTouch(Threads *thread_data) {
+	int row_start, row_end, word_start, word_end;
+	homeRegion(thread_data, &row_start, &row_end, &word_start, &word_end);
+	if (row_start > row_end) { return; }
+	copyRegion(thread_data->initial, thread_data->earth, row_start, row_end, word_start, word_end);
+	copyRegion(thread_data->initial, thread_data->next, row_start, row_end, word_start, word_end);
+	if (thread_data->bytes != NULL) {
+		unpackBoard(thread_data->initial, thread_data->bytes, row_start, row_end);
+		refreshByteHalo(thread_data->bytes, row_start, row_end);
+		ByteBoard *next_bytes = thread_data->next_bytes;
+		memset(next_bytes->cells + (ptrdiff_t)row_start * next_bytes->row_pitch - 1, 0,
+				(size_t)(row_end - row_start + 1) * next_bytes->row_pitch);
+	}
+}
+
+/**
+ * Returns the CPU time the calling thread has used, in nanoseconds.
+ **/
+long long threadTime() {
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ *
+ * rebalanceRows
+ *
+ * Moves the strip boundaries so every strip should take the same time,
+ * going by how long each took since the last rebalance: the time is spread
+ * evenly over a strip's rows and the board is cut into num_threads equal
+ * shares of the total. Every thread runs this on the same loads, so they
+ * all agree on the new strips without talking. Nothing moves unless the
+ * slowest strip ran more than REBALANCE_SLACK over the average.
+ *
+ * @param thread_data; the thread.
+ * @param loads; the time each strip took.
+ * @param generation; the number of iterations simulated so far.
+ * @return void.
+ **/
+void rebalanceRows(Threads *thread_data, const long long *loads, long long generation) {
+	int num_threads = thread_data->num_threads;
+	int num_rows = thread_data->earth->num_rows;
+	int *cuts = thread_data->cuts;
+	double total = 0;
+	double slowest = 0;
+	for (int j = 0; j < num_threads; ++j) {
+		total += loads[j];
+		if (loads[j] > slowest) { slowest = loads[j]; }
+	}
+	if (total <= 0 || slowest <= (1 + REBALANCE_SLACK) * total / num_threads) { return; }
+
+	// Walk the old strips, cutting wherever the running total reaches the
+	// next share. Every strip keeps at least one row.
+	int *old = cuts + num_threads + 1;
+	memcpy(old, cuts, (num_threads + 1) * sizeof(int));
+	int strip = 0;
+	double before = 0;
+	for (int k = 1; k < num_threads; ++k) {
+		double share = total * k / num_threads;
+		while (strip < num_threads - 1 && before + loads[strip] < share) {
+			before += loads[strip];
+			++strip;
+		}
+		int cut = old[strip];
+		if (loads[strip] > 0) {
+			cut += (int)((share - before) / loads[strip] * (old[strip + 1] - old[strip]) + 0.5);
+		}
+		if (cut < cuts[k - 1] + 1) { cut = cuts[k - 1] + 1; }
+		if (cut > num_rows - (num_threads - k)) { cut = num_rows - (num_threads - k); }
+		cuts[k] = cut;
+	}
+	thread_data->row_start = cuts[thread_data->tid];
+	thread_data->row_end = cuts[thread_data->tid + 1] - 1;
+
+	if (thread_data->tid == 0 && thread_data->print_thread == 1) {
+		printf("Rebalanced after %lld iterations:", generation);
+		for (int j = 0; j < num_threads; ++j) { printf(" %d:%d", cuts[j], cuts[j + 1] - 1); }
+		printf("\n");
+	}
+}
+
+/**
+ * Pushes a band onto the bottom of the thread's own deque. Only the owner
+ * calls this, and never with more bands than the deque holds.
+ **/
+void dequePush(BandDeque *deque, int band) {
+	long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	atomic_store_explicit(&deque->bands[bottom % deque->capacity], band, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+/**
+ * Takes a band off the bottom of the thread's own deque, or returns
+ * DEQUE_EMPTY. Only the owner calls this; the last band is settled with a
+ * thief through the compare-and-swap on top.
+ **/
+int dequeTake(BandDeque *deque) {
+	long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+	if (top > bottom) {
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return DEQUE_EMPTY;
+	}
+	int band = atomic_load_explicit(&deque->bands[bottom % deque->capacity], memory_order_relaxed);
+	if (top == bottom) {
+		if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+					memory_order_seq_cst, memory_order_relaxed)) {
+			band = DEQUE_EMPTY;
+		}
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	}
+	return band;
+}
+
+/**
+ * Steals a band off the top of another thread's deque. Returns DEQUE_EMPTY
+ * if there is nothing to steal, or DEQUE_ABORT if another thread got there
+ * first.
+ **/
+int dequeSteal(BandDeque *deque) {
+	long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	if (top >= bottom) { return DEQUE_EMPTY; }
+	int band = atomic_load_explicit(&deque->bands[top % deque->capacity], memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+				memory_order_seq_cst, memory_order_relaxed)) {
+		return DEQUE_ABORT;
+	}
+	return band;
+}
+
+/**
+ *
+ * neighbors
+ *
+ * Determine's the number of live neighbors a cell has by accessing the board
+ * as torus. The halo ring around the board already holds the wrapped edges,
+ * so the neighbors are always just one row or column away.
+ *
+ * @param earth; a pointer to the game board. 
+ * @param row; the row of the cell that we are inspecting for neighbors.
+ * @param col; the column of the cell that we are inspecting for neighbors.
+ * @return neighbors; the number of surrounding live cells. 
+ **/
+int neighbors(Board *earth, int row, int col) {
+	int neighbors = 0;
+	// If there is a live cell at any ofthese indices; increment neighbors.
+	// Check left and right of index for neighbors.
+	neighbors += getCell(earth, row, col - 1);
+	neighbors += getCell(earth, row, col + 1);
+	// Check upper 3 cells for neighbors.
+	neighbors += getCell(earth, row - 1, col);
+	neighbors += getCell(earth, row - 1, col - 1);
+	neighbors += getCell(earth, row - 1, col + 1);
+	// Check lower 3 cells for neighbors.
+	neighbors += getCell(earth, row + 1, col);
+	neighbors += getCell(earth, row + 1, col - 1);
+	neighbors += getCell(earth, row + 1, col + 1);
+	// Return the total number of neighbors.
+	return neighbors;
+}
+
+/**
+ * LIFE_COUNT
+ *
+ * Adds up the eight neighbor words of a word of cells bit-wise with a
+ * carry-save adder network: each row of three (or the two side cells of the
+ * middle row) is added into a sum and carry bit, the sums are added into the
+ * ones bit, and the carries into the twos bit plus carries of weight four.
+ * Declares ones_, twos_, tc_ and c2_ in the enclosing block; the count is 4
+ * or more exactly where tc_ | c2_ is set. Works on any type with bitwise
+ * operators, which is how the scalar and vector kernels share it.
+ **/
+#define LIFE_COUNT(T, uw, u, ue, w, e, dw, d, de) \
+	T ux_ = (uw) ^ (u), us_ = ux_ ^ (ue), uc_ = ((uw) & (u)) | (ux_ & (ue)); \
+	T ms_ = (w) ^ (e), mc_ = (w) & (e); \
+	T dx_ = (dw) ^ (d), ds_ = dx_ ^ (de), dc_ = ((dw) & (d)) | (dx_ & (de)); \
+	T ox_ = us_ ^ ms_, ones_ = ox_ ^ ds_, oc_ = (us_ & ms_) | (ox_ & ds_); \
+	T tx_ = uc_ ^ mc_, ts_ = tx_ ^ dc_, tc_ = (uc_ & mc_) | (tx_ & dc_); \
+	T twos_ = ts_ ^ oc_, c2_ = ts_ & oc_
+
+/**
+ * LIFE_STEP
+ *
+ * Applies B3/S23 to a word of cells at once: a cell is alive next generation
+ * when its count is 3, or 2 and it is already alive.
+ **/
+#define LIFE_STEP(T, out, uw, u, ue, w, m, e, dw, d, de) do { \
+	LIFE_COUNT(T, uw, u, ue, w, e, dw, d, de); \
+	(out) = twos_ & ~(tc_ | c2_) & (ones_ | (m)); \
+} while (0)
+
+/**
+ * LIFE_RULE
+ *
+ * Applies any outer-totalistic rule to a word of cells at once. The full
+ * count (ones, twos, fours, eights) is compared against each neighbor count
+ * the rule mentions, and the matches are merged into born and surviving
+ * masks.
+ **/
+#define LIFE_RULE(T, out, rule, uw, u, ue, w, m, e, dw, d, de) do { \
+	LIFE_COUNT(T, uw, u, ue, w, e, dw, d, de); \
+	T fours_ = tc_ ^ c2_, eights_ = tc_ & c2_; \
+	T born_ = ones_ & ~ones_, stay_ = born_; \
+	for (int n_ = 0; n_ <= 8; ++n_) { \
+		if (!((((rule).birth | (rule).survive) >> n_) & 1)) { continue; } \
+		T eq_ = ((n_ & 1) ? ones_ : ~ones_) & ((n_ & 2) ? twos_ : ~twos_) \
+			& ((n_ & 4) ? fours_ : ~fours_) & ((n_ & 8) ? eights_ : ~eights_); \
+		if (((rule).birth >> n_) & 1) { born_ |= eq_; } \
+		if (((rule).survive >> n_) & 1) { stay_ |= eq_; } \
+	} \
+	(out) = (born_ & ~(m)) | (stay_ & (m)); \
+} while (0)
+
+#ifdef HAVE_X86_SIMD
+/**
+ * Steps words [w, w_end) of a row two at a time with SSE2. The west
+ * and east neighbors come from unaligned loads one word to either side.
+ * Returns the first word it did not handle.
+ **/
+__attribute__((target("sse2")))
+static int stepWordsSse2(const uint64_t *up, const uint64_t *mid, const uint64_t *dn,
+		uint64_t *out, int w, int w_end, Rule rule) {
+	int conway = isConway(rule);
+	for (; w + 2 <= w_end; w += 2) {
+		vec2_u64 u, ul, ur, m, ml, mr, d, dl, dr, res;
+		memcpy(&u, up + w, sizeof(u));
+		memcpy(&ul, up + w - 1, sizeof(ul));
+		memcpy(&ur, up + w + 1, sizeof(ur));
+		memcpy(&m, mid + w, sizeof(m));
+		memcpy(&ml, mid + w - 1, sizeof(ml));
+		memcpy(&mr, mid + w + 1, sizeof(mr));
+		memcpy(&d, dn + w, sizeof(d));
+		memcpy(&dl, dn + w - 1, sizeof(dl));
+		memcpy(&dr, dn + w + 1, sizeof(dr));
+		if (conway) {
+			LIFE_STEP(vec2_u64, res,
+					(u << 1) | (ul >> 63), u, (u >> 1) | (ur << 63),
+					(m << 1) | (ml >> 63), m, (m >> 1) | (mr << 63),
+					(d << 1) | (dl >> 63), d, (d >> 1) | (dr << 63));
+		}
+		else {
+			LIFE_RULE(vec2_u64, res, rule,
+					(u << 1) | (ul >> 63), u, (u >> 1) | (ur << 63),
+					(m << 1) | (ml >> 63), m, (m >> 1) | (mr << 63),
+					(d << 1) | (dl >> 63), d, (d >> 1) | (dr << 63));
+		}
+		memcpy(out + w, &res, sizeof(res));
+	}
+	return w;
+}
+
+/**
+ * Steps words [w, w_end) of a row four at a time with AVX2.
+ * Returns the first word it did not handle.
+ **/
+__attribute__((target("avx2")))
+static int stepWordsAvx2(const uint64_t *up, const uint64_t *mid, const uint64_t *dn,
+		uint64_t *out, int w, int w_end, Rule rule) {
+	int conway = isConway(rule);
+	for (; w + 4 <= w_end; w += 4) {
+		vec4_u64 u, ul, ur, m, ml, mr, d, dl, dr, res;
+		memcpy(&u, up + w, sizeof(u));
+		memcpy(&ul, up + w - 1, sizeof(ul));
+		memcpy(&ur, up + w + 1, sizeof(ur));
+		memcpy(&m, mid + w, sizeof(m));
+		memcpy(&ml, mid + w - 1, sizeof(ml));
+		memcpy(&mr, mid + w + 1, sizeof(mr));
+		memcpy(&d, dn + w, sizeof(d));
+		memcpy(&dl, dn + w - 1, sizeof(dl));
+		memcpy(&dr, dn + w + 1, sizeof(dr));
+		if (conway) {
+			LIFE_STEP(vec4_u64, res,
+					(u << 1) | (ul >> 63), u, (u >> 1) | (ur << 63),
+					(m << 1) | (ml >> 63), m, (m >> 1) | (mr << 63),
+					(d << 1) | (dl >> 63), d, (d >> 1) | (dr << 63));
+		}
+		else {
+			LIFE_RULE(vec4_u64, res, rule,
+					(u << 1) | (ul >> 63), u, (u >> 1) | (ur << 63),
+					(m << 1) | (ml >> 63), m, (m >> 1) | (mr << 63),
+					(d << 1) | (dl >> 63), d, (d >> 1) | (dr << 63));
+		}
+		memcpy(out + w, &res, sizeof(res));
+	}
+	return w;
+}
+#endif
+
+/**
+ *
+ * stepBitBlock
+ *
+ * Computes words w_start..w_end - 1 of rows row_start..row_end of the next
+ * generation a whole word at a time. The halo ring supplies the wrapped rows
+ * and columns, so every word of a row is handled the same way: by the vector
+ * kernel for the selected engine, with any leftovers finished one word at a
+ * time. The halo of the next board is left for refreshHalo.
+ *
+ * @param cur; the board holding the current generation.
+ * @param next; the board to write the next generation into.
+ * @param row_start; the first row to compute.
+ * @param row_end; the last row to compute (inclusive).
+ * @param w_start; the first word of each row to compute.
+ * @param w_end; one past the last word of each row to compute.
+ * @param engine; which word-parallel kernel to use.
+ * @param rule; the rule to apply.
+ * @return void.
+ **/
+void stepBitBlock(const Board *cur, Board *next, int row_start, int row_end,
+		int w_start, int w_end, Engine engine, Rule rule) {
+	int conway = isConway(rule);
+	int num_cols = cur->num_cols;
+	int row_words = cur->row_words;
+	int row_pitch = cur->row_pitch;
+	// Mask off the padding bits past the last column.
+	uint64_t last_mask = ~(uint64_t)0;
+	if (num_cols % WORD_BITS) { last_mask = ((uint64_t)1 << (num_cols % WORD_BITS)) - 1; }
+
+	for (int row = row_start; row <= row_end; ++row) {
+		const uint64_t *mid = cur->cells + (ptrdiff_t)row * row_pitch;
+		const uint64_t *up = mid - row_pitch;
+		const uint64_t *dn = mid + row_pitch;
+		uint64_t *out = next->cells + (ptrdiff_t)row * row_pitch;
+
+		// Widest kernel first.
+		int w = w_start;
+#ifdef HAVE_X86_SIMD
+		if (engine == ENGINE_AVX2) { w = stepWordsAvx2(up, mid, dn, out, w, w_end, rule); }
+		else if (engine == ENGINE_SSE2) { w = stepWordsSse2(up, mid, dn, out, w, w_end, rule); }
+#else
+		(void)engine;
+#endif
+		for (; w < w_end; ++w) {
+			if (conway) {
+				LIFE_STEP(uint64_t, out[w],
+						(up[w] << 1) | (up[w - 1] >> 63), up[w], (up[w] >> 1) | (up[w + 1] << 63),
+						(mid[w] << 1) | (mid[w - 1] >> 63), mid[w], (mid[w] >> 1) | (mid[w + 1] << 63),
+						(dn[w] << 1) | (dn[w - 1] >> 63), dn[w], (dn[w] >> 1) | (dn[w + 1] << 63));
+			}
+			else {
+				LIFE_RULE(uint64_t, out[w], rule,
+						(up[w] << 1) | (up[w - 1] >> 63), up[w], (up[w] >> 1) | (up[w + 1] << 63),
+						(mid[w] << 1) | (mid[w - 1] >> 63), mid[w], (mid[w] >> 1) | (mid[w + 1] << 63),
+						(dn[w] << 1) | (dn[w - 1] >> 63), dn[w], (dn[w] >> 1) | (dn[w + 1] << 63));
+			}
+		}
+		if (w_end == row_words) { out[row_words - 1] &= last_mask; }
+	}
+}
+
+#ifdef HAVE_X86_SIMD
+/**
+ * Steps words [j, j_end) of a row of universes four at a time with AVX2.
+ * A cell's neighbors are whole words lanes apart, so no shifting is
+ * needed. Returns the first word it did not handle.
+ **/
+__attribute__((target("avx2")))
+static int stepSlicesAvx2(const uint64_t *up, const uint64_t *mid, const uint64_t *dn,
+		uint64_t *out, int j, int j_end, int lanes, Rule rule) {
+	int conway = isConway(rule);
+	for (; j + 4 <= j_end; j += 4) {
+		vec4_u64 uw, u, ue, w, m, e, dw, d, de, res;
+		memcpy(&uw, up + j - lanes, sizeof(uw));
+		memcpy(&u, up + j, sizeof(u));
+		memcpy(&ue, up + j + lanes, sizeof(ue));
+		memcpy(&w, mid + j - lanes, sizeof(w));
+		memcpy(&m, mid + j, sizeof(m));
+		memcpy(&e, mid + j + lanes, sizeof(e));
+		memcpy(&dw, dn + j - lanes, sizeof(dw));
+		memcpy(&d, dn + j, sizeof(d));
+		memcpy(&de, dn + j + lanes, sizeof(de));
+		if (conway) { LIFE_STEP(vec4_u64, res, uw, u, ue, w, m, e, dw, d, de); }
+		else { LIFE_RULE(vec4_u64, res, rule, uw, u, ue, w, m, e, dw, d, de); }
+		memcpy(out + j, &res, sizeof(res));
+	}
+	return j;
+}
+#endif
+
+/**
+ *
+ * stepUniverses
+ *
+ * Computes the next generation of every universe in rows row_start..row_end.
+ * The words of a row are handled in one run, since every cell word is
+ * stepped the same way: by AVX2 four at a time for the avx2 engine, and one
+ * at a time for the rest.
+ * The halo of the next universes is left for refreshUniverseHalo.
+ *
+ * @param cur; the universes holding the current generation.
+ * @param next; the universes to write the next generation into.
+ * @param row_start; the first row to step.
+ * @param row_end; the last row to step (inclusive).
+ * @param engine; avx2 for the vector kernel.
+ * @param rule; the rule to apply.
+ * @return void.
+ **/
+void stepUniverses(const Universes *cur, Universes *next, int row_start, int row_end,
+		Engine engine, Rule rule) {
+	int conway = isConway(rule);
+	int lanes = cur->lanes;
+	int j_end = (cur->num_cols + 1) * lanes;
+	for (int row = row_start + 1; row <= row_end + 1; ++row) {
+		const uint64_t *up = cur->base + (size_t)(row - 1) * cur->row_words;
+		const uint64_t *mid = up + cur->row_words;
+		const uint64_t *dn = mid + cur->row_words;
+		uint64_t *out = next->base + (size_t)row * next->row_words;
+		int j = lanes;
+#ifdef HAVE_X86_SIMD
+		if (engine == ENGINE_AVX2) { j = stepSlicesAvx2(up, mid, dn, out, j, j_end, lanes, rule); }
+#else
+		(void)engine;
+#endif
+		for (; j < j_end; ++j) {
+			if (conway) {
+				LIFE_STEP(uint64_t, out[j], up[j - lanes], up[j], up[j + lanes], mid[j - lanes],
+						mid[j], mid[j + lanes], dn[j - lanes], dn[j], dn[j + lanes]);
+			}
+			else {
+				LIFE_RULE(uint64_t, out[j], rule, up[j - lanes], up[j], up[j + lanes],
+						mid[j - lanes], mid[j], mid[j + lanes], dn[j - lanes], dn[j], dn[j + lanes]);
+			}
+		}
+	}
+}
+
+/**
+ * Mixes the bits of x; the finalizer from splitmix64.
+ **/
+static inline uint64_t mix64(uint64_t x) {
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+/**
+ * What a word of cells adds to the board hash: a mix of the word and where
+ * it sits on the board, or 0 for an empty word so an empty board hashes to
+ * 0. The board hash is the XOR of these over every word, so a word that
+ * changes is updated by XORing out its old value and XORing in the new one.
+ **/
+static inline uint64_t wordHash(size_t index, uint64_t word) {
+	return word ? mix64(word + (index + 1) * 0x9E3779B97F4A7C15ULL) : 0;
+}
+
+/**
+ *
+ * blockChanged
+ *
+ * Checks words w_start..w_end - 1 of rows row_start..row_end for cells that
+ * differ between cur and next, leaving out the halo bits that share the
+ * last word of a row. When a hash is given, the change to the board hash
+ * is XORed into it too.
+ *
+ * @param cur; the board holding the current generation.
+ * @param next; the board holding the next generation.
+ * @param row_start; the first row to check.
+ * @param row_end; the last row to check (inclusive).
+ * @param w_start; the first word of each row to check.
+ * @param w_end; one past the last word of each row to check.
+ * @param hash; where to fold in the hash change, or NULL.
+ * @return 1 if any cell changed, 0 otherwise.
+ **/
+int blockChanged(const Board *cur, const Board *next, int row_start, int row_end,
+		int w_start, int w_end, uint64_t *hash) {
+	int row_words = cur->row_words;
+	uint64_t last_mask = ~(uint64_t)0;
+	if (cur->num_cols % WORD_BITS) { last_mask = ((uint64_t)1 << (cur->num_cols % WORD_BITS)) - 1; }
+
+	int changed = 0;
+	uint64_t delta = 0;
+	for (int row = row_start; row <= row_end; ++row) {
+		const uint64_t *old = cur->cells + (ptrdiff_t)row * cur->row_pitch;
+		const uint64_t *new = next->cells + (ptrdiff_t)row * next->row_pitch;
+		for (int w = w_start; w < w_end; ++w) {
+			uint64_t was = old[w];
+			uint64_t now = new[w];
+			if (w == row_words - 1) {
+				was &= last_mask;
+				now &= last_mask;
+			}
+			if (was == now) { continue; }
+			// Without a hash to keep up, the first change settles it.
+			if (hash == NULL) { return 1; }
+			size_t index = (size_t)row * row_words + w;
+			delta ^= wordHash(index, was) ^ wordHash(index, now);
+			changed = 1;
+		}
+	}
+	if (hash != NULL) { *hash ^= delta; }
+	return changed;
+}
+
+/**
+ * Returns the hash of the whole board, built the same way blockChanged
+ * keeps it up to date.
+ **/
+uint64_t boardHash(const Board *board) {
+	uint64_t last_mask = ~(uint64_t)0;
+	if (board->num_cols % WORD_BITS) { last_mask = ((uint64_t)1 << (board->num_cols % WORD_BITS)) - 1; }
+
+	uint64_t hash = 0;
+	for (int row = 0; row < board->num_rows; ++row) {
+		const uint64_t *words = board->cells + (ptrdiff_t)row * board->row_pitch;
+		for (int w = 0; w < board->row_words; ++w) {
+			uint64_t word = words[w];
+			if (w == board->row_words - 1) { word &= last_mask; }
+			hash ^= wordHash((size_t)row * board->row_words + w, word);
+		}
+	}
+	return hash;
+}
+
+/**
+ * Returns whether two boards of the same size hold the same cells, leaving
+ * out the halo columns in the last word of each row.
+ **/
+int boardsEqual(const Board *a, const Board *b) {
+	uint64_t last_mask = ~(uint64_t)0;
+	if (a->num_cols % WORD_BITS) { last_mask = ((uint64_t)1 << (a->num_cols % WORD_BITS)) - 1; }
+
+	for (int row = 0; row < a->num_rows; ++row) {
+		const uint64_t *a_words = a->cells + (ptrdiff_t)row * a->row_pitch;
+		const uint64_t *b_words = b->cells + (ptrdiff_t)row * b->row_pitch;
+		if (memcmp(a_words, b_words, (a->row_words - 1) * sizeof(uint64_t)) != 0
+				|| ((a_words[a->row_words - 1] ^ b_words[a->row_words - 1]) & last_mask)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Starts a history with the hash of the starting board as generation 0,
+ * keeping the board a match turns up on in seen.
+ **/
+void historyInit(History *history, uint64_t hash, Board *seen) {
+	history->hash = hash;
+	history->generation = 0;
+	history->hashes[0] = hash;
+	history->check = 0;
+	history->period = 0;
+	history->seen = seen;
+}
+
+/**
+ *
+ * historyAdd
+ *
+ * Records the hash of the next generation and checks it against the ones
+ * before it, newest first. A match only means the board needs a look from
+ * historyConfirm: to keep it, or, period generations after the first
+ * match, to compare it with the one kept. While a match waits to be
+ * confirmed no others are looked for.
+ *
+ * @param history; the history to add to.
+ * @param hash; the hash of the board one generation on from the newest.
+ * @return the smallest period the board may repeat with, or 0 if it matches
+ * 		none of the generations kept.
+ **/
+int historyAdd(History *history, uint64_t hash) {
+	long long kept = history->generation + 1;
+	if (kept > CYCLE_HISTORY) { kept = CYCLE_HISTORY; }
+	++history->generation;
+
+	int period = 0;
+	if (history->check == history->generation) {
+		// The board kept has to come round again with the same hash.
+		if (history->hashes[(history->generation - history->period) % CYCLE_HISTORY] == hash) {
+			period = history->period;
+		}
+		else {
+			history->check = 0;
+		}
+	}
+	else if (history->check == 0) {
+		for (int p = 1; p <= kept; ++p) {
+			if (history->hashes[(history->generation - p) % CYCLE_HISTORY] == hash) {
+				period = p;
+				history->check = history->generation + p;
+				history->period = p;
+				break;
+			}
+		}
+	}
+	history->hashes[history->generation % CYCLE_HISTORY] = hash;
+	history->hash = hash;
+	return period;
+}
+
+/**
+ *
+ * historyConfirm
+ *
+ * Follows up a match from historyAdd. On the first one the keeper copies
+ * the board into seen; period generations on, the board has to be the
+ * same as the one kept for the cycle to count.
+ *
+ * @param history; the history the match is from.
+ * @param board; the board at the newest generation.
+ * @param keeper; whether this caller copies the board into seen.
+ * @return the period of the cycle once the boards are the same, or 0.
+ **/
+int historyConfirm(History *history, const Board *board, int keeper) {
+	if (history->generation < history->check) {
+		if (keeper) {
+			memcpy(history->seen->base, board->base,
+					(size_t)(board->num_rows + 2) * board->row_pitch * sizeof(uint64_t));
+		}
+		return 0;
+	}
+	if (boardsEqual(board, history->seen)) { return history->period; }
+	history->check = 0;
+	return 0;
+}
+
+/**
+ * Prints what cycle detection found: the board died out, stopped changing,
+ * or repeats every period generations from generation on.
+ **/
+void reportCycle(int period, int extinct, long long generation) {
+	if (extinct) { printf("Died out at generation %lld\n", generation); }
+	else if (period == 1) { printf("Still life at generation %lld\n", generation); }
+	else { printf("Period %d oscillation detected at generation %lld\n", period, generation); }
+}
+
+/**
+ *
+ * tilesCreate
+ *
+ * Sets up activity tracking for a board with square tiles of about
+ * tile_size cells on a side (the width rounded up to whole words). Every
+ * tile starts out stamped as changed in generation 0, so the first
+ * generation computes the whole board.
+ *
+ * @param board; the board the tiles cover.
+ * @param tile_size; the tile edge in cells.
+ * @return the tiles; exits on failure.
+ **/
+Tiles *tilesCreate(const Board *board, int tile_size) {
+	Tiles *tiles = malloc(sizeof(Tiles));
+	if (tiles == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	tiles->tile_rows = tile_size;
+	tiles->tile_words = (tile_size + WORD_BITS - 1) / WORD_BITS;
+	tiles->tiles_down = (board->num_rows + tiles->tile_rows - 1) / tiles->tile_rows;
+	tiles->tiles_across = (board->row_words + tiles->tile_words - 1) / tiles->tile_words;
+	size_t count = (size_t)tiles->tiles_down * tiles->tiles_across;
+	tiles->changed = malloc(count * sizeof(atomic_llong));
+	if (tiles->changed == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	for (size_t t = 0; t < count; ++t) {
+		atomic_init(&tiles->changed[t], 0);
+	}
+	return tiles;
+}
+
+/**
+ * Frees tiles made by tilesCreate. NULL is fine.
+ **/
+void tilesFree(Tiles *tiles) {
+	if (tiles == NULL) { return; }
+	free(tiles->changed);
+	free(tiles);
+}
+
+/**
+ * Returns 1 if the tile at (tile_row, tile_col) or one of its 8 neighbors,
+ * wrapping around the board, changed in the given generation. Tiles are
+ * stamped with the next generation while others are still being checked,
+ * so a later stamp counts too; at worst a quiet tile gets computed.
+ **/
+static int tileActive(const Tiles *tiles, int tile_row, int tile_col, long long generation) {
+	for (int dr = -1; dr <= 1; ++dr) {
+		int r = tile_row + dr;
+		if (r < 0) { r += tiles->tiles_down; }
+		else if (r >= tiles->tiles_down) { r -= tiles->tiles_down; }
+		const atomic_llong *row = tiles->changed + (size_t)r * tiles->tiles_across;
+		for (int dc = -1; dc <= 1; ++dc) {
+			int c = tile_col + dc;
+			if (c < 0) { c += tiles->tiles_across; }
+			else if (c >= tiles->tiles_across) { c -= tiles->tiles_across; }
+			if (atomic_load_explicit(&row[c], memory_order_relaxed) >= generation) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ *
+ * stepBitTiles
+ *
+ * Computes the thread's block of the next generation tile by tile, skipping
+ * every tile whose neighborhood was quiet in the generation just computed.
+ * A skipped tile is the same in the current generation as in the one
+ * before, and so is its next generation; the back board still holds that
+ * older generation, so the tile is already right there and nothing needs
+ * copying. This relies on both boards holding the starting generation
+ * before the first step.
+ *
+ * @param thread_data; the thread's strip, boards and tiles.
+ * @param generation; the number of generations computed so far.
+ * @param hash; where to fold in the change to the board hash, or NULL.
+ * @return void.
+ **/
+void stepBitTiles(Threads *thread_data, long long generation, uint64_t *hash) {
+	Tiles *tiles = thread_data->tiles;
+	const Board *earth = thread_data->earth;
+	Board *next = thread_data->next;
+	int row_start = thread_data->row_start;
+	int row_end = thread_data->row_end;
+	int word_start = thread_data->word_start;
+	int word_end = thread_data->word_end;
+
+	for (int tile_row = row_start / tiles->tile_rows;
+			tile_row <= row_end / tiles->tile_rows; ++tile_row) {
+		// Clip the tile's rows to this thread's strip.
+		int first = tile_row * tiles->tile_rows;
+		int last = first + tiles->tile_rows - 1;
+		if (first < row_start) { first = row_start; }
+		if (last > row_end) { last = row_end; }
+
+		// Step each run of active tiles in one go so the vector kernels get
+		// whole rows to work with, then stamp the tiles that changed. The
+		// tiles are clipped to the block's words too.
+		int tile_col = word_start / tiles->tile_words;
+		int tile_col_end = (word_end - 1) / tiles->tile_words + 1;
+		while (tile_col < tile_col_end) {
+			if (!tileActive(tiles, tile_row, tile_col, generation)) {
+				++tile_col;
+				continue;
+			}
+			int run_end = tile_col + 1;
+			while (run_end < tile_col_end
+					&& tileActive(tiles, tile_row, run_end, generation)) {
+				++run_end;
+			}
+			int w_start = tile_col * tiles->tile_words;
+			int w_end = run_end * tiles->tile_words;
+			if (w_start < word_start) { w_start = word_start; }
+			if (w_end > word_end) { w_end = word_end; }
+			stepBitBlock(earth, next, first, last, w_start, w_end,
+					thread_data->engine, thread_data->bounds->rule);
+
+			for (; tile_col < run_end; ++tile_col) {
+				int tile_start = tile_col * tiles->tile_words;
+				int tile_end = tile_start + tiles->tile_words;
+				if (tile_start < word_start) { tile_start = word_start; }
+				if (tile_end > word_end) { tile_end = word_end; }
+				if (blockChanged(earth, next, first, last, tile_start, tile_end, hash)) {
+					atomic_llong *stamp = &tiles->changed[(size_t)tile_row * tiles->tiles_across + tile_col];
+					long long seen = atomic_load_explicit(stamp, memory_order_relaxed);
+					while (seen < generation + 1 && !atomic_compare_exchange_weak_explicit(stamp,
+								&seen, generation + 1, memory_order_relaxed, memory_order_relaxed)) {
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ *
+ * stepTimeBlock
+ *
+ * Advances the thread's strip up to time_block generations with no
+ * synchronization in between. The strip and time_block rows on either side
+ * of it are copied out of the shared board into the thread's own pair of
+ * boards; each generation stepped there leaves one fewer row valid at
+ * either end, so after k generations exactly the strip is still right and
+ * goes back into the shared back board. The extra rows are computed by the
+ * neighboring threads too, which is the price of syncing only once per
+ * block.
+ *
+ * @param thread_data; the thread's strip and boards.
+ * @param remaining; the number of iterations left to simulate.
+ * @return the number of iterations simulated.
+ **/
+int stepTimeBlock(Threads *thread_data, long long remaining) {
+	const Board *earth = thread_data->earth;
+	Board *cur = thread_data->block;
+	Board *next = thread_data->block_next;
+	int halo = thread_data->time_block;
+	int generations = remaining < halo ? (int)remaining : halo;
+	int num_rows = earth->num_rows;
+	size_t row_bytes = earth->row_pitch * sizeof(uint64_t);
+
+	// Copy the strip and its halo rows, wrapping around the board (more than
+	// once if the halo is taller than the board), halo columns included.
+	for (int row = 0; row < cur->num_rows; ++row) {
+		int src = ((thread_data->row_start - halo + row) % num_rows + num_rows) % num_rows;
+		memcpy(cellWord(cur, row, -1), cellWord(earth, src, -1), row_bytes);
+	}
+
+	for (int g = 1; g <= generations; ++g) {
+		int first = g;
+		int last = cur->num_rows - 1 - g;
+		if (thread_data->engine == ENGINE_LUT) {
+			stepLookupRows(cur, next, thread_data->life_table, first, last, 0, cur->row_words);
+		}
+		else {
+			stepBitBlock(cur, next, first, last, 0, cur->row_words,
+					thread_data->engine, thread_data->bounds->rule);
+		}
+		refreshHalo(next, first, last);
+		Board *swap = cur;
+		cur = next;
+		next = swap;
+	}
+
+	for (int row = thread_data->row_start; row <= thread_data->row_end; ++row) {
+		memcpy(cellWord(thread_data->next, row, -1),
+				cellWord(cur, halo + row - thread_data->row_start, -1), row_bytes);
+	}
+	refreshHalo(thread_data->next, thread_data->row_start, thread_data->row_end);
+	return generations;
+}
+
+/**
+ *
+ * stripDependencies
+ *
+ * Lists the threads a strip has to wait for under NEIGHBOR sync: the owners
+ * of the reach rows above it and the reach rows below it, wrapping around
+ * the board. That is usually just the threads either side, but a strip can
+ * be shorter than the reach.
+ *
+ * @param thread_data; every thread's data, with the strips set.
+ * @param num_threads; the number of threads.
+ * @param tid; the thread to list the dependencies of.
+ * @param reach; how many rows either side a step reads.
+ * @param deps; filled with the thread ids, num_threads entries at most.
+ * @return the number of dependencies.
+ **/
+int stripDependencies(const Threads *thread_data, int num_threads, int tid, int reach,
+		int *deps) {
+	int count = 0;
+	for (int dir = -1; dir <= 1; dir += 2) {
+		int covered = 0;
+		for (int j = tid + dir; covered < reach; j += dir) {
+			int n = (j % num_threads + num_threads) % num_threads;
+			// Gone all the way round the board.
+			if (n == tid) { break; }
+			int seen = 0;
+			for (int d = 0; d < count; ++d) { seen |= deps[d] == n; }
+			if (!seen) { deps[count++] = n; }
+			covered += thread_data[n].row_end - thread_data[n].row_start + 1;
+		}
+	}
+	return count;
+}
+
+/**
+ *
+ * stripWait
+ *
+ * Waits until a strip has finished at least the given generation. It spins
+ * for a little while first, since neighbors are rarely far behind, then
+ * sleeps on the strip's counter with a futex.
+ *
+ * @param strip; the strip to wait for.
+ * @param generation; the generation it has to reach.
+ * @return void.
+ **/
+void stripWait(StripSync *strip, uint32_t generation) {
+	// The counters wrap, so compare the difference.
+	for (int spin = 0; spin < STRIP_SPINS; ++spin) {
+		uint32_t done = atomic_load_explicit(&strip->done, memory_order_acquire);
+		if ((int32_t)(done - generation) >= 0) { return; }
+	}
+	atomic_fetch_add(&strip->waiters, 1);
+	uint32_t done;
+	while ((int32_t)((done = atomic_load(&strip->done)) - generation) < 0) {
+		syscall(SYS_futex, &strip->done, FUTEX_WAIT_PRIVATE, done, NULL, NULL, 0);
+	}
+	atomic_fetch_sub(&strip->waiters, 1);
+}
+
+/**
+ *
+ * stripPublish
+ *
+ * Marks a strip as having finished a generation and wakes anyone asleep
+ * waiting for it. The waiter announces itself before its last look at the
+ * counter and this stores the counter before looking for waiters, so one
+ * of the two always sees the other.
+ *
+ * @param strip; the thread's own strip.
+ * @param generation; the generation it just finished.
+ * @return void.
+ **/
+void stripPublish(StripSync *strip, uint32_t generation) {
+	atomic_store(&strip->done, generation);
+	if (atomic_load(&strip->waiters) > 0) {
+		syscall(SYS_futex, &strip->done, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+/**
+ *
+ * barrierWait
+ *
+ * Waits until every thread has reached the same point, with the barrier
+ * picked by -S. Under NEIGHBOR sync the generations don't use it, but the
+ * start and end of the run still do, on the pthread barrier.
+ *
+ * @param thread_data; the thread.
+ * @return void.
+ **/
+void barrierWait(Threads *thread_data) {
+	if (thread_data->sync_mode == SYNC_SPIN) {
+		spinBarrierWait(thread_data->spin_barrier, &thread_data->sense);
+	}
+	else if (thread_data->sync_mode == SYNC_DISSEMINATION) {
+		disseminationWait(thread_data);
+	}
+	else {
+		pthread_barrier_wait(thread_data->BARRIER);
+	}
+}
+
+/**
+ *
+ * spinBarrierWait
+ *
+ * A sense-reversing barrier. Each thread flips its own sense and counts in;
+ * the last one resets the count and sets the shared sense to match, which
+ * lets the rest go. They spin on it for a while, then sleep on it with a
+ * futex, announcing themselves first so the last thread knows to wake
+ * them, as in stripWait.
+ *
+ * @param barrier; the barrier.
+ * @param sense; the thread's own sense, flipped on every call.
+ * @return void.
+ **/
+void spinBarrierWait(SpinBarrier *barrier, unsigned int *sense) {
+	unsigned int mine = *sense ^= 1;
+	if (atomic_fetch_add(&barrier->count, 1) == barrier->num_threads - 1) {
+		// Nobody counts in again until they see the new sense.
+		atomic_store_explicit(&barrier->count, 0, memory_order_relaxed);
+		atomic_store(&barrier->sense, mine);
+		if (atomic_load(&barrier->waiters) > 0) {
+			syscall(SYS_futex, &barrier->sense, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+		}
+		return;
+	}
+	for (int spin = 0; spin < BARRIER_SPINS; ++spin) {
+		if (atomic_load_explicit(&barrier->sense, memory_order_acquire) == mine) { return; }
+	}
+	atomic_fetch_add(&barrier->waiters, 1);
+	while (atomic_load(&barrier->sense) != mine) {
+		syscall(SYS_futex, &barrier->sense, FUTEX_WAIT_PRIVATE, mine ^ 1, NULL, NULL, 0);
+	}
+	atomic_fetch_sub(&barrier->waiters, 1);
+}
+
+/**
+ *
+ * disseminationWait
+ *
+ * A dissemination barrier. In round k each thread tells the thread 2^k
+ * ahead of it that it has arrived, then waits to hear the same from the
+ * thread 2^k behind. After log2(threads) rounds every thread has heard,
+ * directly or not, from all the others. Each flag has one writer and one
+ * reader and counts the barrier's episodes, so it never needs resetting,
+ * and the waiting is done by stripWait.
+ *
+ * @param thread_data; the thread.
+ * @return void.
+ **/
+void disseminationWait(Threads *thread_data) {
+	uint32_t episode = ++thread_data->episode;
+	int num_threads = thread_data->num_threads;
+	for (int k = 0; k < thread_data->rounds; ++k) {
+		int partner = (thread_data->tid + (1 << k)) % num_threads;
+		stripPublish(&thread_data->flags[partner * thread_data->rounds + k], episode);
+		stripWait(&thread_data->flags[thread_data->tid * thread_data->rounds + k], episode);
+	}
+}
+
+/**
+ *
+ * stepWavefront
+ *
+ * Runs the whole simulation under WAVEFRONT sync. Each thread claims any
+ * band that is ready, steps it one generation and claims again, sleeping
+ * only when nothing is ready, so bands far apart can be several
+ * generations apart and nobody waits for a generation to drain. Leaves the
+ * final boards in earth and next.
+ *
+ * @param thread_data; the thread.
+ * @param iterations; the number of iterations to simulate.
+ * @return the number of iterations simulated.
+ **/
+long long stepWavefront(Threads *thread_data, long long iterations) {
+	Wavefront *wavefront = thread_data->wavefront;
+	int num_rows = thread_data->earth->num_rows;
+	int row_start = thread_data->row_start;
+	int row_end = thread_data->row_end;
+	// Start looking from the band holding the thread's own strip.
+	int first = row_start / wavefront->band_rows;
+	// With nothing to step no band would ever finish, so don't start.
+	if (iterations <= 0) { return 0; }
+	for (;;) {
+		// Read the count first, so a band finishing during the search
+		// keeps the thread from going to sleep.
+		uint32_t seen = atomic_load(&wavefront->progress.done);
+		int band = claimBand(wavefront, first, iterations);
+		if (band == WAVE_DONE) { break; }
+		if (band == WAVE_NONE) {
+			stripWait(&wavefront->progress, seen + 1);
+			continue;
+		}
+
+		long long generation = atomic_load_explicit(&wavefront->bands[band].generation,
+				memory_order_relaxed);
+		thread_data->earth = wavefront->boards[generation & 1];
+		thread_data->next = wavefront->boards[(generation + 1) & 1];
+		thread_data->row_start = band * wavefront->band_rows;
+		thread_data->row_end = thread_data->row_start + wavefront->band_rows - 1;
+		if (thread_data->row_end >= num_rows) { thread_data->row_end = num_rows - 1; }
+		simulateLife(thread_data, generation, iterations - generation);
+		++thread_data->bands_done;
+
+		atomic_store_explicit(&wavefront->bands[band].generation, generation + 1,
+				memory_order_release);
+		atomic_store_explicit(&wavefront->bands[band].busy, 0, memory_order_release);
+		if (generation + 1 == iterations) { atomic_fetch_add(&wavefront->finished, 1); }
+		atomic_fetch_add(&wavefront->progress.done, 1);
+		if (atomic_load(&wavefront->progress.waiters) > 0) {
+			syscall(SYS_futex, &wavefront->progress.done, FUTEX_WAKE_PRIVATE, INT_MAX,
+					NULL, NULL, 0);
+		}
+		first = band;
+	}
+
+	thread_data->earth = wavefront->boards[iterations & 1];
+	thread_data->next = wavefront->boards[(iterations + 1) & 1];
+	thread_data->row_start = row_start;
+	thread_data->row_end = row_end;
+	return iterations;
+}
+
+/**
+ *
+ * claimBand
+ *
+ * Finds and claims a band that is ready to step: one nobody else is
+ * stepping, short of the last generation, whose neighbors (wrapping
+ * around the board) have reached at least its generation. Their rows
+ * it reads are then in the front board, and they are done reading the
+ * rows of it the step overwrites in the back one.
+ *
+ * @param wavefront; the bands.
+ * @param first; the band to look at first.
+ * @param iterations; the generation every band stops at.
+ * @return the band, WAVE_NONE if none is ready, or WAVE_DONE once every
+ * 		band has reached the end.
+ **/
+int claimBand(Wavefront *wavefront, int first, long long iterations) {
+	int num_bands = wavefront->num_bands;
+	if (atomic_load(&wavefront->finished) == num_bands) { return WAVE_DONE; }
+	for (int n = 0; n < num_bands; ++n) {
+		int band = (first + n) % num_bands;
+		WaveBand *wave = &wavefront->bands[band];
+		if (atomic_load_explicit(&wave->busy, memory_order_relaxed)) { continue; }
+		int expected = 0;
+		if (!atomic_compare_exchange_strong(&wave->busy, &expected, 1)) { continue; }
+		// Only the claimer moves a band on, so this holds until it lets go.
+		long long generation = atomic_load_explicit(&wave->generation, memory_order_relaxed);
+		long long above = atomic_load_explicit(
+				&wavefront->bands[(band + num_bands - 1) % num_bands].generation, memory_order_acquire);
+		long long below = atomic_load_explicit(
+				&wavefront->bands[(band + 1) % num_bands].generation, memory_order_acquire);
+		if (generation < iterations && above >= generation && below >= generation) {
+			return band;
+		}
+		atomic_store_explicit(&wave->busy, 0, memory_order_release);
+	}
+	return WAVE_NONE;
+}
+
+/**
+ *
+ * stepColumnSums
+ *
+ * Computes rows row_start..row_end of the next generation on a byte-per-cell
+ * board. col_sums holds, for every column (halo included), the sum of the
+ * current row and the rows above and below it. Moving down a row only adds
+ * the new bottom row and drops the old top one, and each cell's count is the
+ * sum of three neighboring column sums. That count includes the cell itself,
+ * so under Conway's rule a cell lives when it is 3, or 4 and the cell is
+ * already alive. Every cell is decided exactly once, with no branches, so the
+ * loops vectorize. Other rules go through a small table indexed by state and
+ * count instead.
+ *
+ * @param cur; the board holding the current generation.
+ * @param next; the board to write the next generation into.
+ * @param col_sums; scratch space of num_cols + 2 bytes owned by the thread.
+ * @param row_start; the first row to compute.
+ * @param row_end; the last row to compute (inclusive).
+ * @param rule; the rule to apply.
+ * @return void.
+ **/
+void stepColumnSums(const ByteBoard *cur, ByteBoard *next, uint8_t *col_sums,
+		int row_start, int row_end, Rule rule) {
+	int num_cols = cur->num_cols;
+	int row_pitch = cur->row_pitch;
+	int conway = isConway(rule);
+	// Next state by [alive][count including the cell itself].
+	uint8_t next_state[2][10];
+	for (int count = 0; count < 10; ++count) {
+		next_state[0][count] = (rule.birth >> count) & 1;
+		next_state[1][count] = count > 0 ? (rule.survive >> (count - 1)) & 1 : 0;
+	}
+	// Index the sums the same way as the rows, from column -1.
+	uint8_t *sums = col_sums + 1;
+
+	// Prime the sums with the rows around the first row of the strip.
+	const uint8_t *mid = cur->cells + (ptrdiff_t)row_start * row_pitch;
+	for (int col = -1; col <= num_cols; ++col) {
+		sums[col] = mid[col - row_pitch] + mid[col] + mid[col + row_pitch];
+	}
+
+	for (int row = row_start; row <= row_end; ++row) {
+		mid = cur->cells + (ptrdiff_t)row * row_pitch;
+		uint8_t *out = next->cells + (ptrdiff_t)row * row_pitch;
+
+		// Slide the window down: drop the row two above, add the row below.
+		if (row > row_start) {
+			const uint8_t *gone = mid - 2 * row_pitch;
+			const uint8_t *added = mid + row_pitch;
+			for (int col = -1; col <= num_cols; ++col) {
+				sums[col] = sums[col] - gone[col] + added[col];
+			}
+		}
+
+		if (conway) {
+			for (int col = 0; col < num_cols; ++col) {
+				uint8_t count = sums[col - 1] + sums[col] + sums[col + 1];
+				out[col] = (count == 3) | (mid[col] & (count == 4));
+			}
+		}
+		else {
+			for (int col = 0; col < num_cols; ++col) {
+				uint8_t count = sums[col - 1] + sums[col] + sums[col + 1];
+				out[col] = next_state[mid[col]][count];
+			}
+		}
+	}
+}
+
+/**
+ *
+ * buildLifeTable
+ *
+ * Fills the lookup table used by the lut and lut2 engines. Each of the
+ * 65536 entries is a 4x4 block of cells: bits 0-3 are its top row (leftmost
+ * cell in bit 0), bits 4-7 the next row and so on. The entry holds the next
+ * generation of the block's center 2x2 under the rule: bits 0-1 the top pair
+ * and bits 2-3 the bottom pair.
+ *
+ * @param rule; the rule to apply.
+ * @param table; space for LIFE_TABLE_SIZE entries.
+ * @return void.
+ **/
+void buildLifeTable(Rule rule, uint8_t *table) {
+	for (int block = 0; block < LIFE_TABLE_SIZE; ++block) {
+		uint8_t result = 0;
+		// Visit the four center cells.
+		for (int row = 1; row <= 2; ++row) {
+			for (int col = 1; col <= 2; ++col) {
+				int count = 0;
+				for (int dr = -1; dr <= 1; ++dr) {
+					for (int dc = -1; dc <= 1; ++dc) {
+						if (dr == 0 && dc == 0) { continue; }
+						count += (block >> ((row + dr) * 4 + col + dc)) & 1;
+					}
+				}
+				int alive = (block >> (row * 4 + col)) & 1;
+				int next = alive ? (rule.survive >> count) & 1 : (rule.birth >> count) & 1;
+				result |= next << ((row - 1) * 2 + (col - 1));
+			}
+		}
+		table[block] = result;
+	}
+}
+
+/**
+ * Returns the table index of the 4x4 block whose rows are the low four bits
+ * of r0..r3.
+ **/
+static inline unsigned gatherBlock(uint64_t r0, uint64_t r1, uint64_t r2, uint64_t r3) {
+	return (r0 & 15) | (r1 & 15) << 4 | (r2 & 15) << 8 | (r3 & 15) << 12;
+}
+
+/**
+ * Returns the 64 bits of the 128-bit value hi:lo starting at bit shift.
+ **/
+static inline uint64_t windowBits(uint64_t lo, uint64_t hi, int shift) {
+	if (shift == 0) { return lo; }
+	return (lo >> shift) | (hi << (WORD_BITS - shift));
+}
+
+/**
+ *
+ * stepLookupRows
+ *
+ * Computes rows row_start..row_end of the next generation two rows and two
+ * columns at a time. For the 2x2 block at (row, col) the 4x4 block around it
+ * (rows row-1..row+2, columns col-1..col+2) is gathered from four rows of
+ * the board and looked up in the table. If the strip has an odd number of
+ * rows, the second row of the last pair is computed and thrown away.
+ *
+ * @param cur; the board holding the current generation.
+ * @param next; the board to write the next generation into.
+ * @param table; the table built by buildLifeTable.
+ * @param row_start; the first row to compute.
+ * @param row_end; the last row to compute (inclusive).
+ * @param w_start; the first word of each row to compute.
+ * @param w_end; one past the last word of each row to compute.
+ * @return void.
+ **/
+void stepLookupRows(const Board *cur, Board *next, const uint8_t *table,
+		int row_start, int row_end, int w_start, int w_end) {
+	int num_rows = cur->num_rows;
+	int row_words = cur->row_words;
+	int row_pitch = cur->row_pitch;
+	uint64_t last_mask = ~(uint64_t)0;
+	if (cur->num_cols % WORD_BITS) { last_mask = ((uint64_t)1 << (cur->num_cols % WORD_BITS)) - 1; }
+
+	for (int row = row_start; row <= row_end; row += 2) {
+		// The four input rows, wrapped around the torus.
+		const uint64_t *rows[4];
+		for (int k = 0; k < 4; ++k) {
+			rows[k] = cur->cells + (ptrdiff_t)((row - 1 + k + num_rows) % num_rows) * row_pitch;
+		}
+		uint64_t *top = next->cells + (ptrdiff_t)row * row_pitch;
+		uint64_t *bottom = (row + 1 <= row_end) ? top + row_pitch : NULL;
+
+		for (int w = w_start; w < w_end; ++w) {
+			// lo:hi holds columns 64w - 1 onwards of each input row.
+			uint64_t lo[4], hi[4];
+			for (int k = 0; k < 4; ++k) {
+				lo[k] = (rows[k][w] << 1) | (rows[k][w - 1] >> 63);
+				hi[k] = (rows[k][w] >> 63) | (rows[k][w + 1] << 1);
+			}
+			uint64_t top_word = 0;
+			uint64_t bottom_word = 0;
+			for (int shift = 0; shift < WORD_BITS - 2; shift += 2) {
+				uint64_t result = table[gatherBlock(lo[0] >> shift, lo[1] >> shift,
+						lo[2] >> shift, lo[3] >> shift)];
+				top_word |= (result & 3) << shift;
+				bottom_word |= (result >> 2) << shift;
+			}
+			// The last block reaches into hi.
+			uint64_t result = table[gatherBlock(windowBits(lo[0], hi[0], WORD_BITS - 2),
+					windowBits(lo[1], hi[1], WORD_BITS - 2), windowBits(lo[2], hi[2], WORD_BITS - 2),
+					windowBits(lo[3], hi[3], WORD_BITS - 2))];
+			top_word |= (result & 3) << (WORD_BITS - 2);
+			bottom_word |= (result >> 2) << (WORD_BITS - 2);
+			top[w] = top_word;
+			if (bottom != NULL) { bottom[w] = bottom_word; }
+		}
+		if (w_end == row_words) {
+			top[row_words - 1] &= last_mask;
+			if (bottom != NULL) { bottom[row_words - 1] &= last_mask; }
+		}
+	}
+}
+
+/**
+ *
+ * stepLookupRows2
+ *
+ * Like stepLookupRows, but jumps two generations: each 2x2 block of the
+ * result comes from the 6x6 block around it. The 4x4 block one generation
+ * ahead is put together from four lookups (the two on its right are reused
+ * as the left ones of the next block over), and a fifth lookup on that gives
+ * the 2x2 two generations ahead. Needs the two-column halo on each side.
+ *
+ * @param cur; the board holding the current generation.
+ * @param next; the board to write the generation after next into.
+ * @param table; the table built by buildLifeTable.
+ * @param row_start; the first row to compute.
+ * @param row_end; the last row to compute (inclusive).
+ * @return void.
+ **/
+void stepLookupRows2(const Board *cur, Board *next, const uint8_t *table,
+		int row_start, int row_end) {
+	int num_rows = cur->num_rows;
+	int row_words = cur->row_words;
+	int row_pitch = cur->row_pitch;
+	uint64_t last_mask = ~(uint64_t)0;
+	if (cur->num_cols % WORD_BITS) { last_mask = ((uint64_t)1 << (cur->num_cols % WORD_BITS)) - 1; }
+
+	for (int row = row_start; row <= row_end; row += 2) {
+		// The six input rows, wrapped around the torus.
+		const uint64_t *rows[6];
+		for (int k = 0; k < 6; ++k) {
+			rows[k] = cur->cells + (ptrdiff_t)(((row - 2 + k) % num_rows + num_rows) % num_rows) * row_pitch;
+		}
+		uint64_t *top = next->cells + (ptrdiff_t)row * row_pitch;
+		uint64_t *bottom = (row + 1 <= row_end) ? top + row_pitch : NULL;
+
+		for (int w = 0; w < row_words; ++w) {
+			// lo:hi holds columns 64w - 2 onwards of each input row; the
+			// blocks in the upper half of the word read them from half.
+			uint64_t lo[6], half[6];
+			for (int k = 0; k < 6; ++k) {
+				lo[k] = (rows[k][w] << 2) | (rows[k][w - 1] >> 62);
+				uint64_t hi = (rows[k][w] >> 62) | (rows[k][w + 1] << 2);
+				half[k] = windowBits(lo[k], hi, WORD_BITS / 2);
+			}
+			uint64_t top_word = 0;
+			uint64_t bottom_word = 0;
+			unsigned upper_left = 0;
+			unsigned lower_left = 0;
+			for (int shift = 0; shift < WORD_BITS; shift += 2) {
+				// Six columns of each input row, starting two left of the
+				// block.
+				unsigned strip[6];
+				for (int k = 0; k < 6; ++k) {
+					uint64_t bits = shift < WORD_BITS / 2 ? lo[k] : half[k];
+					strip[k] = (bits >> (shift % (WORD_BITS / 2))) & 63;
+				}
+				// One generation ahead: the 2x2 blocks up-left, up-right,
+				// down-left and down-right of the center.
+				if (shift == 0) {
+					upper_left = table[gatherBlock(strip[0], strip[1], strip[2], strip[3])];
+					lower_left = table[gatherBlock(strip[2], strip[3], strip[4], strip[5])];
+				}
+				unsigned upper_right = table[gatherBlock(strip[0] >> 2, strip[1] >> 2,
+						strip[2] >> 2, strip[3] >> 2)];
+				unsigned lower_right = table[gatherBlock(strip[2] >> 2, strip[3] >> 2,
+						strip[4] >> 2, strip[5] >> 2)];
+				// Stitch them into the 4x4 block and look that up.
+				uint64_t result = table[gatherBlock((upper_left & 3) | (upper_right & 3) << 2,
+						(upper_left >> 2) | (upper_right >> 2) << 2,
+						(lower_left & 3) | (lower_right & 3) << 2,
+						(lower_left >> 2) | (lower_right >> 2) << 2)];
+				top_word |= (result & 3) << shift;
+				bottom_word |= (result >> 2) << shift;
+				upper_left = upper_right;
+				lower_left = lower_right;
+			}
+			top[w] = top_word;
+			if (bottom != NULL) { bottom[w] = bottom_word; }
+		}
+		top[row_words - 1] &= last_mask;
+		if (bottom != NULL) { bottom[row_words - 1] &= last_mask; }
+	}
+}
+
+/**
+ * Hashes a node's level and children for the hash-consing buckets.
+ **/
+static inline uint32_t hlHash(int level, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+	uint64_t h = ((uint64_t)a * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)b * 0xC2B2AE3D27D4EB4FULL);
+	h ^= ((uint64_t)c * 0x165667B19E3779F9ULL) ^ ((uint64_t)d * 0xD6E8FEB86659FD93ULL) ^ (uint64_t)level;
+	h ^= h >> 29;
+	return (uint32_t)h;
+}
+
+/**
+ *
+ * hlMake
+ *
+ * Returns the unique node with the given level and children (for a level 2
+ * leaf, a holds the 4x4 cells and the others are 0), creating it if needed.
+ * If the node budget, less the memo's share, is used up it flags an
+ * overflow and returns HL_NONE.
+ *
+ * @param hl; the HashLife state.
+ * @param level; the level of the node.
+ * @param a, b, c, d; the nw, ne, sw and se children.
+ * @return the node.
+ **/
+static uint32_t hlMake(HashLife *hl, int level, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+	uint32_t *bucket = &hl->buckets[hlHash(level, a, b, c, d) & hl->bucket_mask];
+	for (uint32_t id = *bucket; id != HL_NONE; id = hl->nodes[id].next) {
+		HLNode *node = &hl->nodes[id];
+		if (node->level == level && node->child[0] == a && node->child[1] == b
+				&& node->child[2] == c && node->child[3] == d) {
+			return id;
+		}
+	}
+	// Take a node off the free list, then from the pool, growing the pool
+	// up to the budget.
+	uint32_t id = hl->free_list;
+	if (id != HL_NONE) {
+		hl->free_list = hl->nodes[id].next;
+	}
+	else {
+		if ((size_t)hl->num_nodes + hl->built_cost >= hl->capacity) {
+			hl->overflow = 1;
+			return HL_NONE;
+		}
+		if (hl->num_nodes == hl->allocated) {
+			uint32_t grown = hl->allocated > hl->capacity / 2 ? hl->capacity : hl->allocated * 2;
+			HLNode *nodes = realloc(hl->nodes, (size_t)grown * sizeof(HLNode));
+			if (nodes == NULL) {
+				hl->overflow = 1;
+				return HL_NONE;
+			}
+			hl->nodes = nodes;
+			hl->allocated = grown;
+		}
+		id = hl->num_nodes++;
+	}
+	HLNode *node = &hl->nodes[id];
+	node->level = level;
+	node->child[0] = a;
+	node->child[1] = b;
+	node->child[2] = c;
+	node->child[3] = d;
+	node->result = HL_NONE;
+	node->result_step = 0;
+	node->mark = 0;
+	node->next = *bucket;
+	*bucket = id;
+	++hl->live_nodes;
+	return id;
+}
+
+/**
+ * Returns quadrant q (0 nw, 1 ne, 2 sw, 3 se) of a node.
+ **/
+static inline uint32_t hlChild(const HashLife *hl, uint32_t id, int q) {
+	return hl->nodes[id].child[q];
+}
+
+/**
+ * Fills rows[0..7] with the 8x8 cells of a level 3 node, column 0 in bit 0.
+ **/
+static void hlRows8(const HashLife *hl, uint32_t id, uint8_t rows[8]) {
+	for (int q = 0; q < 4; ++q) {
+		uint32_t bits = hl->nodes[hlChild(hl, id, q)].child[0];
+		for (int r = 0; r < 4; ++r) {
+			uint8_t cells = (bits >> (r * 4)) & 15;
+			rows[(q >> 1) * 4 + r] |= cells << ((q & 1) * 4);
+		}
+	}
+}
+
+/**
+ * Returns the lookup table index of the 4x4 window of rows whose top-left
+ * cell is at (o, p).
+ **/
+static inline unsigned hlWindow(const uint8_t *rows, int o, int p) {
+	return ((rows[o] >> p) & 15) | ((rows[o + 1] >> p) & 15) << 4
+		| ((rows[o + 2] >> p) & 15) << 8 | ((rows[o + 3] >> p) & 15) << 12;
+}
+
+/**
+ *
+ * hlCentre
+ *
+ * Returns the centre half (level k - 1) of a level k node, not advanced.
+ *
+ * @param hl; the HashLife state.
+ * @param id; the node.
+ * @return the centre node.
+ **/
+static uint32_t hlCentre(HashLife *hl, uint32_t id) {
+	int level = hl->nodes[id].level;
+	if (level == 3) {
+		uint8_t rows[8] = {0};
+		hlRows8(hl, id, rows);
+		uint32_t bits = 0;
+		for (int r = 0; r < 4; ++r) {
+			bits |= ((rows[r + 2] >> 2) & 15u) << (r * 4);
+		}
+		return hlMake(hl, 2, bits, 0, 0, 0);
+	}
+	return hlMake(hl, level - 1, hlChild(hl, hlChild(hl, id, 0), 3), hlChild(hl, hlChild(hl, id, 1), 2),
+			hlChild(hl, hlChild(hl, id, 2), 1), hlChild(hl, hlChild(hl, id, 3), 0));
+}
+
+/**
+ *
+ * hlBase
+ *
+ * Advances the centre 4x4 of a level 3 (8x8) node by one generation, or two
+ * when step allows, with the 4x4 -> 2x2 lookup table. Two generations go
+ * through the 6x6 centre one generation ahead.
+ *
+ * @param hl; the HashLife state.
+ * @param id; the level 3 node.
+ * @param step; log2 of the generations to advance (0 or 1).
+ * @return the level 2 result.
+ **/
+static uint32_t hlBase(HashLife *hl, uint32_t id, int step) {
+	uint8_t rows[8] = {0};
+	hlRows8(hl, id, rows);
+	uint32_t bits = 0;
+	if (step == 0) {
+		// Each window at (o, p) gives rows o+1..o+2, columns p+1..p+2.
+		for (int o = 1; o <= 3; o += 2) {
+			for (int p = 1; p <= 3; p += 2) {
+				unsigned result = hl->table[hlWindow(rows, o, p)];
+				bits |= (result & 3) << ((o - 1) * 4 + p - 1);
+				bits |= (result >> 2) << (o * 4 + p - 1);
+			}
+		}
+	}
+	else {
+		// rows 1..6, columns 1..6 one generation ahead.
+		uint8_t ahead[6] = {0};
+		for (int o = 0; o <= 4; o += 2) {
+			for (int p = 0; p <= 4; p += 2) {
+				unsigned result = hl->table[hlWindow(rows, o, p)];
+				ahead[o] |= (result & 3) << p;
+				ahead[o + 1] |= (result >> 2) << p;
+			}
+		}
+		for (int o = 0; o <= 2; o += 2) {
+			for (int p = 0; p <= 2; p += 2) {
+				unsigned result = hl->table[hlWindow(ahead, o, p)];
+				bits |= (result & 3) << (o * 4 + p);
+				bits |= (result >> 2) << ((o + 1) * 4 + p);
+			}
+		}
+	}
+	return hlMake(hl, 2, bits, 0, 0, 0);
+}
+
+/**
+ *
+ * hlResult
+ *
+ * The HashLife recursion: returns the centre half of a level k node advanced
+ * 2^min(step, k - 2) generations, memoized on the node. The node is split
+ * into nine overlapping level k - 1 squares whose results are stitched into
+ * four level k - 1 squares; at full speed those are advanced again, and for
+ * smaller steps their centres are taken as they are.
+ *
+ * @param hl; the HashLife state.
+ * @param id; the node to advance (level 3 or more).
+ * @param step; log2 of the largest jump wanted.
+ * @return the level k - 1 result, or HL_NONE after an overflow.
+ **/
+static uint32_t hlResult(HashLife *hl, uint32_t id, int step) {
+	if (hl->overflow) { return HL_NONE; }
+	int level = hl->nodes[id].level;
+	int effective = step < level - 2 ? step : level - 2;
+	if (hl->nodes[id].result != HL_NONE && hl->nodes[id].result_step == effective) {
+		return hl->nodes[id].result;
+	}
+	uint32_t result;
+	if (level == 3) {
+		result = hlBase(hl, id, effective);
+	}
+	else {
+		uint32_t nw = hlChild(hl, id, 0), ne = hlChild(hl, id, 1);
+		uint32_t sw = hlChild(hl, id, 2), se = hlChild(hl, id, 3);
+		uint32_t sub[9];
+		sub[0] = nw;
+		sub[1] = hlMake(hl, level - 1, hlChild(hl, nw, 1), hlChild(hl, ne, 0), hlChild(hl, nw, 3), hlChild(hl, ne, 2));
+		sub[2] = ne;
+		sub[3] = hlMake(hl, level - 1, hlChild(hl, nw, 2), hlChild(hl, nw, 3), hlChild(hl, sw, 0), hlChild(hl, sw, 1));
+		sub[4] = hlMake(hl, level - 1, hlChild(hl, nw, 3), hlChild(hl, ne, 2), hlChild(hl, sw, 1), hlChild(hl, se, 0));
+		sub[5] = hlMake(hl, level - 1, hlChild(hl, ne, 2), hlChild(hl, ne, 3), hlChild(hl, se, 0), hlChild(hl, se, 1));
+		sub[6] = sw;
+		sub[7] = hlMake(hl, level - 1, hlChild(hl, sw, 1), hlChild(hl, se, 0), hlChild(hl, sw, 3), hlChild(hl, se, 2));
+		sub[8] = se;
+		for (int k = 0; k < 9; ++k) {
+			sub[k] = hlResult(hl, sub[k], step);
+		}
+		uint32_t quad[4];
+		for (int q = 0; q < 4; ++q) {
+			int k = (q >> 1) * 3 + (q & 1);
+			uint32_t square = hlMake(hl, level - 1, sub[k], sub[k + 1], sub[k + 3], sub[k + 4]);
+			if (hl->overflow) { return HL_NONE; }
+			if (effective == level - 2) { quad[q] = hlResult(hl, square, step); }
+			else { quad[q] = hlCentre(hl, square); }
+		}
+		result = hlMake(hl, level - 1, quad[0], quad[1], quad[2], quad[3]);
+	}
+	if (hl->overflow) { return HL_NONE; }
+	hl->nodes[id].result = result;
+	hl->nodes[id].result_step = effective;
+	return result;
+}
+
+/**
+ *
+ * hlBuildPeriodic
+ *
+ * Builds the node for the 2^level square of the torus tiled across the
+ * plane whose top-left cell is (y, x), with y and x already reduced onto
+ * the board. Squares are memoized by position, so however large the square,
+ * only as many nodes are built per level as there are distinct offsets.
+ * The memo counts against the node budget, so a memo that can't grow
+ * within it is an overflow too.
+ *
+ * @param hl; the HashLife state.
+ * @param board; the board being tiled.
+ * @param level; the level of the square.
+ * @param y; the row of its top-left cell.
+ * @param x; the column of its top-left cell.
+ * @return the node, or HL_NONE after an overflow.
+ **/
+static uint32_t hlBuildPeriodic(HashLife *hl, const Board *board, int level, int64_t y, int64_t x) {
+	if (hl->overflow) { return HL_NONE; }
+	// Look the square up in the memo, growing it when half full.
+	if (hl->built_count * 2 >= hl->built_size) {
+		size_t old_size = hl->built_size;
+		size_t new_size = old_size ? old_size * 2 : 4096;
+		size_t cost = (new_size * sizeof(HLBuildEntry) + sizeof(HLNode) + sizeof(uint32_t) - 1)
+			/ (sizeof(HLNode) + sizeof(uint32_t));
+		if (hl->num_nodes + cost >= hl->capacity) {
+			hl->overflow = 1;
+			return HL_NONE;
+		}
+		HLBuildEntry *old = hl->built;
+		hl->built_size = new_size;
+		hl->built_cost = cost;
+		hl->built = calloc(hl->built_size, sizeof(HLBuildEntry));
+		if (hl->built == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		hl->built_count = 0;
+		for (size_t i = 0; i < old_size; ++i) {
+			if (old[i].level == 0) { continue; }
+			size_t slot = hlHash(old[i].level, (uint32_t)old[i].y, (uint32_t)old[i].x, 0, 0) & (hl->built_size - 1);
+			while (hl->built[slot].level != 0) { slot = (slot + 1) & (hl->built_size - 1); }
+			hl->built[slot] = old[i];
+			++hl->built_count;
+		}
+		free(old);
+	}
+	size_t slot = hlHash(level, (uint32_t)y, (uint32_t)x, 0, 0) & (hl->built_size - 1);
+	while (hl->built[slot].level != 0) {
+		HLBuildEntry *entry = &hl->built[slot];
+		if (entry->level == (uint32_t)level && entry->y == y && entry->x == x) { return entry->node; }
+		slot = (slot + 1) & (hl->built_size - 1);
+	}
+
+	uint32_t id;
+	if (level == 2) {
+		uint32_t bits = 0;
+		for (int r = 0; r < 4; ++r) {
+			for (int c = 0; c < 4; ++c) {
+				bits |= (uint32_t)getCell(board, (y + r) % board->num_rows, (x + c) % board->num_cols) << (r * 4 + c);
+			}
+		}
+		id = hlMake(hl, 2, bits, 0, 0, 0);
+	}
+	else {
+		int64_t half = (int64_t)1 << (level - 1);
+		int64_t y2 = (y + half % board->num_rows) % board->num_rows;
+		int64_t x2 = (x + half % board->num_cols) % board->num_cols;
+		uint32_t nw = hlBuildPeriodic(hl, board, level - 1, y, x);
+		uint32_t ne = hlBuildPeriodic(hl, board, level - 1, y, x2);
+		uint32_t sw = hlBuildPeriodic(hl, board, level - 1, y2, x);
+		uint32_t se = hlBuildPeriodic(hl, board, level - 1, y2, x2);
+		if (hl->overflow) { return HL_NONE; }
+		id = hlMake(hl, level, nw, ne, sw, se);
+	}
+	if (hl->overflow) { return HL_NONE; }
+	// The recursion may have grown the memo; find the free slot again.
+	slot = hlHash(level, (uint32_t)y, (uint32_t)x, 0, 0) & (hl->built_size - 1);
+	while (hl->built[slot].level != 0) { slot = (slot + 1) & (hl->built_size - 1); }
+	hl->built[slot].level = level;
+	hl->built[slot].y = y;
+	hl->built[slot].x = x;
+	hl->built[slot].node = id;
+	++hl->built_count;
+	return id;
+}
+
+/**
+ *
+ * hlWriteBoard
+ *
+ * Writes the cells of a node whose top-left cell is (y, x) into the part of
+ * the board it overlaps. The board must already be cleared.
+ *
+ * @param hl; the HashLife state.
+ * @param id; the node.
+ * @param y; the row of its top-left cell.
+ * @param x; the column of its top-left cell.
+ * @param board; the board to write.
+ * @return void.
+ **/
+static void hlWriteBoard(const HashLife *hl, uint32_t id, int64_t y, int64_t x, Board *board) {
+	if (y >= board->num_rows || x >= board->num_cols) { return; }
+	int level = hl->nodes[id].level;
+	if (level == 2) {
+		uint32_t bits = hl->nodes[id].child[0];
+		for (int r = 0; r < 4 && bits != 0; ++r) {
+			for (int c = 0; c < 4; ++c) {
+				if (((bits >> (r * 4 + c)) & 1) && y + r < board->num_rows && x + c < board->num_cols) {
+					setCell(board, y + r, x + c, 1);
+				}
+			}
+		}
+		return;
+	}
+	int64_t half = (int64_t)1 << (level - 1);
+	for (int q = 0; q < 4; ++q) {
+		hlWriteBoard(hl, hl->nodes[id].child[q], y + (q >> 1) * half, x + (q & 1) * half, board);
+	}
+}
+
+/**
+ * Marks a node and everything below it as reachable.
+ **/
+static void hlMark(HashLife *hl, uint32_t id) {
+	if (id == HL_NONE || hl->nodes[id].mark) { return; }
+	hl->nodes[id].mark = 1;
+	if (hl->nodes[id].level > 2) {
+		for (int q = 0; q < 4; ++q) { hlMark(hl, hl->nodes[id].child[q]); }
+	}
+}
+
+/**
+ *
+ * hlCollect
+ *
+ * Evicts nodes from the cache: everything not reachable from the last
+ * window or its result goes back on the free list, and memoized results
+ * pointing at evicted nodes are forgotten.
+ *
+ * @param hl; the HashLife state.
+ * @return void.
+ **/
+static void hlCollect(HashLife *hl) {
+	hlMark(hl, hl->root);
+	hlMark(hl, hl->root_result);
+	memset(hl->buckets, 0, ((size_t)hl->bucket_mask + 1) * sizeof(uint32_t));
+	hl->free_list = HL_NONE;
+	hl->live_nodes = 0;
+	for (uint32_t id = hl->num_nodes - 1; id > HL_NONE; --id) {
+		HLNode *node = &hl->nodes[id];
+		if (!node->mark) {
+			node->level = 0;
+			node->next = hl->free_list;
+			hl->free_list = id;
+			continue;
+		}
+		uint32_t *bucket = &hl->buckets[hlHash(node->level, node->child[0], node->child[1],
+				node->child[2], node->child[3]) & hl->bucket_mask];
+		node->next = *bucket;
+		*bucket = id;
+		++hl->live_nodes;
+	}
+	for (uint32_t id = 1; id < hl->num_nodes; ++id) {
+		HLNode *node = &hl->nodes[id];
+		if (node->result != HL_NONE && !hl->nodes[node->result].mark) { node->result = HL_NONE; }
+	}
+	for (uint32_t id = 1; id < hl->num_nodes; ++id) { hl->nodes[id].mark = 0; }
+}
+
+/**
+ * Throws away every node in the cache, and the build memo with them.
+ **/
+static void hlFlush(HashLife *hl) {
+	free(hl->built);
+	hl->built = NULL;
+	hl->built_size = 0;
+	hl->built_count = 0;
+	hl->built_cost = 0;
+	memset(hl->buckets, 0, ((size_t)hl->bucket_mask + 1) * sizeof(uint32_t));
+	hl->num_nodes = 1;
+	hl->live_nodes = 0;
+	hl->free_list = HL_NONE;
+	hl->root = HL_NONE;
+	hl->root_result = HL_NONE;
+	hl->overflow = 0;
+}
+
+/**
+ *
+ * hlJump
+ *
+ * Advances the board 2^step generations. HashLife works on the plane, so
+ * the torus is tiled across it: the window is the 2^level square of that
+ * tiling starting 2^(level-2) cells up and left of the board, which puts the
+ * board at the top-left of the window's centre. The result is that centre
+ * 2^step generations later, and it is copied back onto the board.
+ *
+ * @param hl; the HashLife state.
+ * @param board; the board to advance.
+ * @param step; log2 of the number of generations.
+ * @return 1 on success and 0 if the node budget ran out.
+ **/
+static int hlJump(HashLife *hl, Board *board, int step) {
+	int level = hl->min_level > step + 2 ? hl->min_level : step + 2;
+	int64_t quarter = (int64_t)1 << (level - 2);
+	int64_t y = ((-quarter) % board->num_rows + board->num_rows) % board->num_rows;
+	int64_t x = ((-quarter) % board->num_cols + board->num_cols) % board->num_cols;
+	uint32_t root = hlBuildPeriodic(hl, board, level, y, x);
+	hl->built_count = 0;
+	if (hl->built != NULL) { memset(hl->built, 0, hl->built_size * sizeof(HLBuildEntry)); }
+	uint32_t result = hlResult(hl, root, step);
+	if (hl->overflow) { return 0; }
+	hl->root = root;
+	hl->root_result = result;
+	memset(board->base, 0, (size_t)(board->num_rows + 2) * board->row_pitch * sizeof(uint64_t));
+	hlWriteBoard(hl, result, 0, 0, board);
+	refreshHalo(board, 0, board->num_rows - 1);
+	return 1;
+}
+
+/**
+ *
+ * hashlifeCreate
+ *
+ * Sets up the HashLife engine for a board.
+ *
+ * @param mem_bytes; the memory budget for the node cache.
+ * @param table; the 4x4 -> 2x2 table built by buildLifeTable.
+ * @param board; the board that will be run.
+ * @return hl; the HashLife state.
+ **/
+HashLife *hashlifeCreate(size_t mem_bytes, const uint8_t *table, const Board *board) {
+	HashLife *hl = calloc(1, sizeof(HashLife));
+	if (hl == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	size_t capacity = mem_bytes / (sizeof(HLNode) + sizeof(uint32_t));
+	if (capacity > UINT32_MAX - 1) { capacity = UINT32_MAX - 1; }
+	if (capacity < 4096) { capacity = 4096; }
+	hl->capacity = capacity;
+	uint32_t buckets = 1024;
+	while ((size_t)buckets * 2 <= capacity && buckets < (UINT32_C(1) << 31)) { buckets *= 2; }
+	hl->bucket_mask = buckets - 1;
+	hl->buckets = calloc(buckets, sizeof(uint32_t));
+	hl->allocated = capacity < 65536 ? capacity : 65536;
+	hl->nodes = malloc((size_t)hl->allocated * sizeof(HLNode));
+	if (hl->buckets == NULL || hl->nodes == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	// Node 0 is the dummy HL_NONE.
+	memset(&hl->nodes[0], 0, sizeof(HLNode));
+	hl->num_nodes = 1;
+	hl->table = table;
+	// The window's centre has to cover the whole board.
+	int size = board->num_rows > board->num_cols ? board->num_rows : board->num_cols;
+	hl->min_level = 3;
+	while (((int64_t)1 << (hl->min_level - 1)) < size) { ++hl->min_level; }
+	return hl;
+}
+
+/**
+ *
+ * hashlifeFree
+ *
+ * Releases the HashLife engine.
+ *
+ * @param hl; the HashLife state.
+ * @return void.
+ **/
+void hashlifeFree(HashLife *hl) {
+	if (hl == NULL) { return; }
+	free(hl->nodes);
+	free(hl->buckets);
+	free(hl->built);
+	free(hl);
+}
+
+/**
+ *
+ * hashlifeRun
+ *
+ * Advances the board by the given number of iterations with HashLife,
+ * taking the largest power-of-two jumps that fit. When the cache is three
+ * quarters full the nodes the next jump is unlikely to need are evicted; if
+ * a jump runs out of nodes anyway, the cache is emptied and the jump is
+ * retried, halving it until it fits.
+ *
+ * @param hl; the HashLife state.
+ * @param earth; the board, which holds the final generation afterwards.
+ * @param iterations; the number of iterations to run.
+ * @param renderer; where to send the board after each jump, or NULL.
+ * @return void.
+ **/
+void hashlifeRun(HashLife *hl, Board *earth, long long iterations, Renderer *renderer) {
+	long long done = 0;
+	int max_step = HL_MAX_STEP;
+	while (done < iterations) {
+		int step = 0;
+		while (step < max_step && ((long long)1 << (step + 1)) <= iterations - done) { ++step; }
+		if (!hlJump(hl, earth, step)) {
+			hlFlush(hl);
+			if (!hlJump(hl, earth, step)) {
+				hlFlush(hl);
+				if (step == 0) {
+					printf("ERROR: hashlife ran out of memory; raise -m\n");
+					exit(1);
+				}
+				max_step = step - 1;
+				continue;
+			}
+		}
+		done += (long long)1 << step;
+		if (renderer != NULL) { renderPush(renderer, earth, done - 1, 0); }
+		if (hl->live_nodes > hl->capacity / 4 * 3) { hlCollect(hl); }
+	}
+	if (renderer != NULL) { renderLast(renderer, earth, done - 1); }
+}
+
+/**
+ *
+ * sparseCreate
+ *
+ * Sets up the sparse engine with the live cells of a board. Empty words are
+ * skipped whole, so a mostly dead board is scanned quickly.
+ *
+ * @param board; the board to read.
+ * @return sp; the sparse engine state.
+ **/
+Sparse *sparseCreate(const Board *board) {
+	Sparse *sp = calloc(1, sizeof(Sparse));
+	if (sp == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	for (int row = 0; row < board->num_rows; ++row) {
+		const uint64_t *words = board->cells + (ptrdiff_t)row * board->row_pitch;
+		for (int w = 0; w < board->row_words; ++w) {
+			uint64_t word = words[w];
+			// Drop the halo bits past the last column.
+			if (w == board->row_words - 1 && board->num_cols % WORD_BITS) {
+				word &= ((uint64_t)1 << (board->num_cols % WORD_BITS)) - 1;
+			}
+			while (word != 0) {
+				if (sp->population == sp->live_size) {
+					sp->live_size = sp->live_size ? sp->live_size * 2 : 1024;
+					sp->live = realloc(sp->live, sp->live_size * sizeof(SparseCell));
+					if (sp->live == NULL) {
+						printf("ERROR: memory allocation failed\n");
+						exit(1);
+					}
+				}
+				sp->live[sp->population].row = row;
+				sp->live[sp->population].col = w * WORD_BITS + __builtin_ctzll(word);
+				sp->hash ^= mix64(((uint64_t)row << 32 | (uint32_t)sp->live[sp->population].col) + 1);
+				++sp->population;
+				word &= word - 1;
+			}
+		}
+	}
+	return sp;
+}
+
+/**
+ *
+ * sparseFree
+ *
+ * Releases the sparse engine.
+ *
+ * @param sp; the sparse engine state.
+ * @return void.
+ **/
+void sparseFree(Sparse *sp) {
+	if (sp == NULL) { return; }
+	free(sp->live);
+	free(sp->slots);
+	free(sp);
+}
+
+/**
+ * Finds (or claims) the slot of a cell in the count table.
+ **/
+static inline SparseSlot *sparseSlot(Sparse *sp, int row, int col) {
+	uint64_t key = (uint64_t)row << 32 | (uint32_t)col;
+	size_t mask = sp->num_slots - 1;
+	size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+	while (sp->slots[slot].key != key) {
+		if (sp->slots[slot].key == SPARSE_EMPTY) {
+			sp->slots[slot].key = key;
+			sp->slots[slot].count = 0;
+			sp->slots[slot].alive = 0;
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return &sp->slots[slot];
+}
+
+/**
+ *
+ * sparseStep
+ *
+ * Advances the live cell list one generation. Every live cell adds one to
+ * the count of each of its eight neighbors (wrapped around the torus) in a
+ * hash table, then the table, which only holds live cells and their
+ * neighbors, is swept for the cells alive next generation. The work is
+ * proportional to the population, not the board.
+ *
+ * @param sp; the sparse engine state.
+ * @param rule; the rule to apply (no B0 rules).
+ * @param num_rows; the number of rows on the torus.
+ * @param num_cols; the number of columns on the torus.
+ * @return void.
+ **/
+void sparseStep(Sparse *sp, Rule rule, int num_rows, int num_cols) {
+	// Keep the table at most half full: each live cell touches nine slots.
+	size_t wanted = 1024;
+	while (wanted < sp->population * 18) { wanted *= 2; }
+	if (wanted != sp->num_slots) {
+		free(sp->slots);
+		sp->slots = malloc(wanted * sizeof(SparseSlot));
+		if (sp->slots == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		sp->num_slots = wanted;
+	}
+	for (size_t i = 0; i < sp->num_slots; ++i) { sp->slots[i].key = SPARSE_EMPTY; }
+
+	for (size_t i = 0; i < sp->population; ++i) {
+		int row = sp->live[i].row;
+		int col = sp->live[i].col;
+		int up = row == 0 ? num_rows - 1 : row - 1;
+		int down = row == num_rows - 1 ? 0 : row + 1;
+		int left = col == 0 ? num_cols - 1 : col - 1;
+		int right = col == num_cols - 1 ? 0 : col + 1;
+		sparseSlot(sp, row, col)->alive = 1;
+		++sparseSlot(sp, up, left)->count;
+		++sparseSlot(sp, up, col)->count;
+		++sparseSlot(sp, up, right)->count;
+		++sparseSlot(sp, row, left)->count;
+		++sparseSlot(sp, row, right)->count;
+		++sparseSlot(sp, down, left)->count;
+		++sparseSlot(sp, down, col)->count;
+		++sparseSlot(sp, down, right)->count;
+	}
+
+	// The next generation can't have more cells than the table holds.
+	size_t population = 0;
+	for (size_t i = 0; i < sp->num_slots; ++i) {
+		SparseSlot *slot = &sp->slots[i];
+		if (slot->key == SPARSE_EMPTY) { continue; }
+		uint16_t counts = slot->alive ? rule.survive : rule.birth;
+		int alive = (counts >> slot->count) & 1;
+		// Every cell that is born or dies flips its key in the hash.
+		if (alive != slot->alive) { sp->hash ^= mix64(slot->key + 1); }
+		if (!alive) { continue; }
+		if (population == sp->live_size) {
+			sp->live_size = sp->live_size ? sp->live_size * 2 : 1024;
+			sp->live = realloc(sp->live, sp->live_size * sizeof(SparseCell));
+			if (sp->live == NULL) {
+				printf("ERROR: memory allocation failed\n");
+				exit(1);
+			}
+		}
+		sp->live[population].row = (int)(slot->key >> 32);
+		sp->live[population].col = (int)(uint32_t)slot->key;
+		++population;
+	}
+	sp->population = population;
+}
+
+/**
+ *
+ * sparseWriteBoard
+ *
+ * Replaces the contents of a board with the live cell list.
+ *
+ * @param sp; the sparse engine state.
+ * @param board; the board to write.
+ * @return void.
+ **/
+void sparseWriteBoard(const Sparse *sp, Board *board) {
+	memset(board->base, 0, (size_t)(board->num_rows + 2) * board->row_pitch * sizeof(uint64_t));
+	for (size_t i = 0; i < sp->population; ++i) {
+		setCell(board, sp->live[i].row, sp->live[i].col, 1);
+	}
+	refreshHalo(board, 0, board->num_rows - 1);
+}
+
+/**
+ *
+ * sparseRun
+ *
+ * Runs the sparse engine on the main thread and leaves the final generation
+ * on the board.
+ *
+ * @param earth; the board, which holds the final generation afterwards.
+ * @param bounds; a pointer to an init_data struct holding the config file
+ * 			specifications.
+ * @param renderer; where to send the board after each iteration, or NULL.
+ * @param detect; stop early once the board repeats itself.
+ * @return void.
+ **/
+void sparseRun(Board *earth, init_data *bounds, Renderer *renderer, int detect) {
+	// Birth on zero neighbors would fill every empty cell on the board.
+	if (bounds->rule.birth & 1) {
+		printf("ERROR: the sparse engine can't run rules with B0\n");
+		exit(1);
+	}
+	Sparse *sp = sparseCreate(earth);
+	History *history = NULL;
+	if (detect) {
+		history = malloc(sizeof(History));
+		if (history == NULL) {
+			printf("ERROR: memory allocation failed\n");
+			exit(1);
+		}
+		historyInit(history, sp->hash, boardAlloc(earth->num_rows, earth->num_cols));
+	}
+	long long end = bounds->iterations;
+	for (long long i = 0; i < end; ++i) {
+		sparseStep(sp, bounds->rule, earth->num_rows, earth->num_cols);
+		if (renderer != NULL) {
+			sparseWriteBoard(sp, earth);
+			renderPush(renderer, earth, i, 0);
+		}
+		// Once the board repeats, only step on to the phase the full run
+		// would end in. A match is checked on the board itself, written
+		// out just for that.
+		if (history != NULL) {
+			int period = historyAdd(history, sp->hash);
+			if (period) {
+				sparseWriteBoard(sp, earth);
+				period = historyConfirm(history, earth, 1);
+			}
+			if (period) {
+				reportCycle(period, sp->population == 0, i + 1);
+				end = i + 1 + (end - i - 1) % period;
+				boardFree(history->seen);
+				free(history);
+				history = NULL;
+			}
+		}
+	}
+	if (history != NULL) { boardFree(history->seen); }
+	free(history);
+	sparseWriteBoard(sp, earth);
+	if (renderer != NULL) { renderLast(renderer, earth, end - 1); }
+	sparseFree(sp);
+}
+
+/**
+ *
+ * parseRule
+ *
+ * Parses a rule in B/S notation ("B3/S23", case-insensitive, either half
+ * first) or the older survive/birth notation ("23/3").
+ *
+ * @param text; the rule to parse.
+ * @param rule; where to store the parsed rule.
+ * @return 1 on success and 0 if the text is not a rule.
+ **/
+int parseRule(const char *text, Rule *rule) {
+	Rule parsed = {0, 0};
+	uint16_t *counts = NULL;
+	// Without a B or S the first half is the survive counts.
+	int bs = strpbrk(text, "BbSs") != NULL;
+	if (!bs) { counts = &parsed.survive; }
+	for (const char *c = text; *c != '\0'; ++c) {
+		if (*c == 'B' || *c == 'b') { counts = &parsed.birth; }
+		else if (*c == 'S' || *c == 's') { counts = &parsed.survive; }
+		else if (*c == '/') {
+			if (!bs) { counts = &parsed.birth; }
+		}
+		else if (*c >= '0' && *c <= '8' && counts != NULL) { *counts |= 1 << (*c - '0'); }
+		else if (*c != ' ' && *c != '\n' && *c != '\r') { return 0; }
+	}
+	*rule = parsed;
+	return 1;
+}
+
+/**
+ *
+ * isConway
+ *
+ * Checks whether a rule is Conway's B3/S23, which several kernels have a
+ * faster path for.
+ *
+ * @param rule; the rule to check.
+ * @return 1 if the rule is B3/S23 and 0 otherwise.
+ **/
+int isConway(Rule rule) {
+	return rule.birth == (1 << 3) && rule.survive == ((1 << 2) | (1 << 3));
+}
+
+/**
+ *
+ * parseEngine
+ *
+ * Converts an engine name given with -e into an Engine. Vector engines that
+ * this CPU (or build) can't run fall back to the next narrower one.
+ *
+ * @param name; the engine name.
+ * @return engine; the selected engine.
+ **/
+Engine parseEngine(const char *name) {
+	Engine engine = NUM_ENGINES;
+	for (int i = 0; i < NUM_ENGINES; ++i) {
+		if (strcmp(name, engineName(i)) == 0) { engine = i; }
+	}
+	if (engine == NUM_ENGINES) {
+		printf("ERROR: unknown engine %s\n", name);
+		usage();
+		exit(1);
+	}
+	// The vector engines are ordered by width.
+	if ((engine == ENGINE_SSE2 || engine == ENGINE_AVX2) && engine > bestEngine()) {
+		printf("%s is not supported here; falling back to %s\n", name, engineName(bestEngine()));
+		engine = bestEngine();
+	}
+	return engine;
+}
+
+/**
+ *
+ * bestEngine
+ *
+ * Returns the widest word-parallel engine this CPU supports.
+ *
+ * @param None.
+ * @return engine; the default engine.
+ **/
+Engine bestEngine() {
+#ifdef HAVE_X86_SIMD
+	if (__builtin_cpu_supports("avx2")) { return ENGINE_AVX2; }
+	if (__builtin_cpu_supports("sse2")) { return ENGINE_SSE2; }
+#endif
+	return ENGINE_WORD;
+}
+
+/**
+ *
+ * engineName
+ *
+ * Returns the -e name of an engine.
+ *
+ * @param engine; the engine.
+ * @return the engine's name.
+ **/
+const char *engineName(Engine engine) {
+	switch (engine) {
+		case ENGINE_SCALAR: return "scalar";
+		case ENGINE_WORD: return "word";
+		case ENGINE_SSE2: return "sse2";
+		case ENGINE_AVX2: return "avx2";
+		case ENGINE_COLSUM: return "colsum";
+		case ENGINE_LUT: return "lut";
+		case ENGINE_LUT2: return "lut2";
+		case ENGINE_HASHLIFE: return "hashlife";
+		case ENGINE_SPARSE: return "sparse";
+		case NUM_ENGINES: break;
+	}
+	return "unknown";
+}
+
+/**
+ *
+ * parseSync
+ *
+ * Converts a sync name given with -S into a SyncMode.
+ *
+ * @param name; the sync name.
+ * @return the selected way of keeping the threads in step.
+ **/
+SyncMode parseSync(const char *name) {
+	for (int i = 0; i < NUM_SYNCS; ++i) {
+		if (strcmp(name, syncName(i)) == 0) { return i; }
+	}
+	printf("ERROR: unknown sync %s\n", name);
+	usage();
+	exit(1);
+}
+
+/**
+ * Returns the -S name of a way of keeping the threads in step.
+ **/
+const char *syncName(SyncMode sync_mode) {
+	switch (sync_mode) {
+		case SYNC_PTHREAD: return "pthread";
+		case SYNC_NEIGHBOR: return "neighbor";
+		case SYNC_SPIN: return "spin";
+		case SYNC_DISSEMINATION: return "dissemination";
+		case SYNC_WAVEFRONT: return "wavefront";
+		case NUM_SYNCS: break;
+	}
+	return "unknown";
+}
+
+/**
+ *
+ * parsePartition
+ *
+ * Converts a partition name given with -P into a Partition.
+ *
+ * @param name; the partition name.
+ * @return the selected way of handing out rows.
+ **/
+Partition parsePartition(const char *name) {
+	for (int i = 0; i < NUM_PARTITIONS; ++i) {
+		if (strcmp(name, partitionName(i)) == 0) { return i; }
+	}
+	printf("ERROR: unknown partition %s\n", name);
+	usage();
+	exit(1);
+}
+
+/**
+ * Returns the -P name of a way of handing out rows.
+ **/
+const char *partitionName(Partition partition) {
+	switch (partition) {
+		case PARTITION_STATIC: return "static";
+		case PARTITION_STEAL: return "steal";
+		case NUM_PARTITIONS: break;
+	}
+	return "unknown";
+}
+
+/**
+ *
+ * parseCpuList
+ *
+ * Parses a list of CPUs in the kernel's cpulist format, e.g. 0,2,4-7.
+ *
+ * @param text; the list; it may end in a newline.
+ * @param cpus; filled with the CPUs in the order given.
+ * @param max_cpus; the most CPUs cpus holds.
+ * @return the number of CPUs, or -1 if the list doesn't parse.
+ **/
+int parseCpuList(const char *text, int *cpus, int max_cpus) {
+	int count = 0;
+	while (*text != '\0' && *text != '\n') {
+		char *end;
+		long first = strtol(text, &end, 10);
+		if (end == text || first < 0) { return -1; }
+		long last = first;
+		if (*end == '-') {
+			text = end + 1;
+			last = strtol(text, &end, 10);
+			if (end == text || last < first) { return -1; }
+		}
+		for (long cpu = first; cpu <= last; ++cpu) {
+			if (cpu >= CPU_SETSIZE || count == max_cpus) { return -1; }
+			cpus[count++] = (int)cpu;
+		}
+		text = end;
+		if (*text == ',') { ++text; }
+		else if (*text != '\0' && *text != '\n') { return -1; }
+	}
+	return count;
+}
+
+/**
+ *
+ * cpuOrder
+ *
+ * Lists the CPUs threads are pinned to, in thread order. compact fills one
+ * NUMA node's CPUs before moving to the next, so neighboring strips share a
+ * node; scatter takes one CPU from each node in turn, to use every node's
+ * memory bandwidth. Anything else is read as a list of CPUs. The nodes
+ * come from /sys; without them every CPU counts as node 0.
+ *
+ * @param spec; compact, scatter or a CPU list.
+ * @param order; filled with up to CPU_SETSIZE CPUs.
+ * @return the number of CPUs in order.
+ **/
+int cpuOrder(const char *spec, int *order) {
+	cpu_set_t allowed;
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+		printf("ERROR: could not read the CPU affinity\n");
+		exit(1);
+	}
+	int count = 0;
+	if (strcmp(spec, "compact") != 0 && strcmp(spec, "scatter") != 0) {
+		count = parseCpuList(spec, order, CPU_SETSIZE);
+		if (count < 0) {
+			printf("ERROR: could not parse CPU list %s\n", spec);
+			usage();
+		}
+		for (int i = 0; i < count; ++i) {
+			if (!CPU_ISSET(order[i], &allowed)) {
+				printf("ERROR: CPU %d is not available\n", order[i]);
+				exit(1);
+			}
+		}
+		return count;
+	}
+
+	// Map each CPU to its node.
+	static int node_of[CPU_SETSIZE];
+	static int cpus[CPU_SETSIZE];
+	int num_nodes = 1;
+	memset(node_of, 0, sizeof(node_of));
+	for (int node = 0; node < MAX_NODES; ++node) {
+		char path[64];
+		char line[4096];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+		FILE *file = fopen(path, "r");
+		if (file == NULL) { continue; }
+		int n = fgets(line, sizeof(line), file) != NULL ? parseCpuList(line, cpus, CPU_SETSIZE) : -1;
+		fclose(file);
+		for (int i = 0; i < n; ++i) { node_of[cpus[i]] = node; }
+		if (n > 0 && node + 1 > num_nodes) { num_nodes = node + 1; }
+	}
 
-	return 0;
+	if (strcmp(spec, "compact") == 0) {
+		for (int node = 0; node < num_nodes; ++node) {
+			for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+				if (CPU_ISSET(cpu, &allowed) && node_of[cpu] == node) { order[count++] = cpu; }
+			}
+		}
+		return count;
+	}
+	// Scatter: each pass takes the next CPU from every node that has one.
+	int next_cpu[MAX_NODES] = {0};
+	int total = CPU_COUNT(&allowed);
+	while (count < total) {
+		for (int node = 0; node < num_nodes; ++node) {
+			int cpu = next_cpu[node];
+			while (cpu < CPU_SETSIZE && !(CPU_ISSET(cpu, &allowed) && node_of[cpu] == node)) { ++cpu; }
+			if (cpu < CPU_SETSIZE) { order[count++] = cpu; }
+			next_cpu[node] = cpu + 1;
+		}
+	}
+	return count;
 }
 
 /**
- * Used for testing if calls to pthread_barrier_wait worked or not
- * Not used in this code.
+ *
+ * timeDiff
+ *
+ * Calculates the elapsed time of between the call to gettimeofday for the
+ * beginning and end of the simulation 
+ *
+ * @param result; the timeval struct to save the resulting difference in. 
+ * @param start; the timeval struct storing the starting time.
+ * @param end; the timeval struct storing the ending time. 
+ * @return void. 
  **/
-void Pthread_barrier_wait(pthread_barrier_t *BARRIER) {
-	int check = pthread_barrier_wait(BARRIER);
-	int success = 0;
-	if (check == PTHREAD_BARRIER_SERIAL_THREAD) { 
-		success = 1;
+void timeDiff (struct timeval *result, struct timeval *start, struct timeval *end){
+	// Preform the carry operations.
+	if (end->tv_usec < start->tv_usec) {
+		int nsec = (start->tv_usec - end->tv_usec) / 1000000 + 1;
+		start->tv_usec -= 1000000 * nsec;
+		start->tv_sec += nsec;
 	}
-	if (success) { printf("success\n"); }
-}	
+	if (end->tv_usec - start->tv_usec > 1000000) {
+		int nsec = (end->tv_usec - start->tv_usec) / 1000000;
+		start->tv_usec += 1000000 * nsec;
+		start->tv_sec -= nsec;
+	}
+	// Compute the differences.
+	result->tv_sec = end->tv_sec - start->tv_sec;
+	result->tv_usec = end->tv_usec - start->tv_usec;
+}
 
 /**
- * threadFunc
  *
- * This function is a thread routine that will have each thread running it
- * simulate the game of life
+ * checkRanks
  *
- * @param args: gets deconstructed into a Threads struct that holds all
- * 		necessary data for the Game of Life Simulation.
- * @return void
-**/
-void *threadFunc(void *args) {
-	// Deconstruct the argument
-	Threads *thread_data = (Threads*)args;
-	// For each iteration:
-	for(int i = 0; i < thread_data->bounds->iterations; ++i) {
-		
-		// Simulate life for each iteration
-		pthread_barrier_wait(thread_data->BARRIER);
-		simulateLife(thread_data);
-		pthread_barrier_wait(thread_data->BARRIER);
-
-		// If this is the designated board for printing then print the board
-		// here and wait.
-		if (thread_data->tid == 0 && thread_data->verbose == 1) { printEarth(thread_data->earth, *(thread_data->bounds), i); }
-		pthread_barrier_wait(thread_data->BARRIER);
+ * Works out how many ranks a distributed run has, and whether the board
+ * and the other options allow one.
+ *
+ * @param ranks; the ranks, with what the command line set.
+ * @param peers; the --peers list, or NULL.
+ * @param options; the options each rank runs its band with.
+ * @param bounds; the board's size.
+ * @return NULL if the run can go ahead, or what is wrong with it.
+ **/
+const char *checkRanks(Ranks *ranks, const char *peers, const Options *options,
+		const init_data *bounds) {
+	if (ranks->rank >= 0 && peers == NULL) {
+		return "--rank needs --peers";
+	}
+	if (peers != NULL) {
+		int num_peers = 1;
+		for (const char *c = peers; *c; ++c) { num_peers += *c == ','; }
+		if (ranks->num_ranks > 0 && ranks->num_ranks != num_peers) {
+			return "--ranks does not match the number of --peers";
+		}
+		ranks->num_ranks = num_peers;
+		if (ranks->rank < 0 || ranks->rank >= num_peers) {
+			return "--peers needs a --rank below the number of peers";
+		}
+	}
+	if (ranks->num_ranks < 2) {
+		return "a distributed run needs at least 2 ranks";
+	}
+	if (bounds->num_rows / ranks->num_ranks < ranks->halo) {
+		return "every rank needs at least --halo rows";
+	}
+	if (options->verbose || options->detect) {
+		return "a distributed run does not work with -v or -d";
 	}
-	// If printing per thread is enabled, do so here. 
-	pthread_barrier_wait(thread_data->BARRIER);
-	if (thread_data->print_thread == 1) {
-		printf("Thread %d:\t %d:%d\t(%d)\n", thread_data->tid, thread_data->row_start, 
-				thread_data->row_end, thread_data->row_end - thread_data->row_start);
-	} /* When each thread is done then return */
-	pthread_barrier_wait(thread_data->BARRIER);
 	return NULL;
 }
 
+/**
+ *
+ * launchRanks
+ *
+ * Starts a distributed run on this host: opens a listening socket on a
+ * free port for every rank, then forks a process for each rank but 0,
+ * which this process goes on to run.
+ *
+ * @param ranks; the ranks; rank and listenfd are set for whichever process
+ * 			returns.
+ * @return the peers list, for rankConnect.
+ **/
+char *launchRanks(Ranks *ranks) {
+	int num_ranks = ranks->num_ranks;
+	int *listenfds = malloc(num_ranks * sizeof(int));
+	char *peers = malloc((size_t)num_ranks * (sizeof("localhost:,") + NI_MAXSERV));
+	ranks->children = malloc(num_ranks * sizeof(pid_t));
+	if (listenfds == NULL || peers == NULL || ranks->children == NULL) {
+		printf("ERROR: memory allocation failed\n");
+		exit(1);
+	}
+	int len = 0;
+	for (int r = 0; r < num_ranks; ++r) {
+		struct sockaddr_storage addr;
+		socklen_t addr_len = sizeof(addr);
+		char port[NI_MAXSERV];
+		listenfds[r] = open_listenfd("0");
+		if (listenfds[r] < 0
+				|| getsockname(listenfds[r], (struct sockaddr *)&addr, &addr_len) != 0
+				|| getnameinfo((struct sockaddr *)&addr, addr_len, NULL, 0, port, sizeof(port),
+					NI_NUMERICSERV) != 0) {
+			printf("ERROR: could not open a socket for rank %d\n", r);
+			exit(1);
+		}
+		len += sprintf(peers + len, "%slocalhost:%s", r > 0 ? "," : "", port);
+	}
+
+	// Anything still buffered would be printed again by every child.
+	fflush(stdout);
+	ranks->rank = 0;
+	for (int r = 1; r < num_ranks; ++r) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			printf("ERROR: could not start rank %d\n", r);
+			exit(1);
+		}
+		if (pid == 0) {
+			ranks->rank = r;
+			free(ranks->children);
+			ranks->children = NULL;
+			break;
+		}
+		ranks->children[r] = pid;
+	}
+	for (int r = 0; r < num_ranks; ++r) {
+		if (r != ranks->rank) { close(listenfds[r]); }
+	}
+	ranks->listenfd = listenfds[ranks->rank];
+	free(listenfds);
+	return peers;
+}
 
 /**
  *
- * Usage 
+ * waitRanks
  *
- * Prints out the possible command line options.
+ * Waits for the ranks launchRanks started to exit.
  *
- * @param None 
+ * @param ranks; the ranks.
  * @return void.
  **/
-void usage () {
-	printf("Command line should look like:\n");
-	printf("./gol (-v) -c <configuration file>; OR\n");
-	printf("./gol -l; OR\n");
-	printf("./gol (-v) -n <server-configuration file>\n");
-	printf("-v enables verbose mode\n");
-	exit(1);
+void waitRanks(Ranks *ranks) {
+	if (ranks->children == NULL) { return; }
+	int failed = 0;
+	for (int r = 1; r < ranks->num_ranks; ++r) {
+		int status;
+		if (waitpid(ranks->children[r], &status, 0) < 0
+				|| !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			failed = 1;
+		}
+	}
+	free(ranks->children);
+	ranks->children = NULL;
+	if (failed) {
+		printf("ERROR: a rank failed\n");
+		exit(1);
+	}
 }
 
 /**
  *
- * initEarth 
+ * peerAddress
  *
- * Initializes the game board and the initial condition given by the user's
- * specified configuration file.
+ * Finds a rank's entry in the peers list.
  *
- * @param config_file; the user specified configuration file name.
- * @param bounds; a pointer to an init_data struct holding the config file
- * 			specifications.
- * @param verbose; a signifier to whether or not user specifies verbose mode.
- * @return earth; a char pointer to the game board.
+ * @param peers; the list, host:port for every rank, separated by commas.
+ * @param rank; the rank to look up.
+ * @param port; set to the port, which is in the returned string.
+ * @return the host, to be freed by the caller.
  **/
-char *initEarth(char *config_file, init_data *bounds, int verbose){
-	// Open the configuration file.	
-	FILE *init_state = fopen(config_file, "r");
-	if (init_state == NULL) {
-		printf("ERROR: %s could not be opened\n", config_file);
+char *peerAddress(const char *peers, int rank, char **port) {
+	for (int r = 0; r < rank; ++r) { peers = strchr(peers, ',') + 1; }
+	size_t len = strcspn(peers, ",");
+	char *host = strndup(peers, len);
+	char *colon = host != NULL ? strrchr(host, ':') : NULL;
+	if (colon == NULL) {
+		printf("ERROR: --peers needs host:port for every rank\n");
 		exit(1);
 	}
-	// Read the game specifications. Give an error message if values are not
-	// appropriate.
-	int ret = 0;	
-	ret = fscanf(init_state, "%d", &bounds->num_rows);
-	if (ret <= 0) { printf("ERROR\n"); }
-	ret = fscanf(init_state, "%d", &bounds->num_cols);
-	if (ret <= 0) { printf("ERROR\n"); }
-	ret = fscanf(init_state, "%d", &bounds->iterations);
-	if (ret < 0) { printf("ERROR\n"); }
-	ret = fscanf(init_state, "%d", &bounds->init_pairs);
-	if (ret < 0) { printf("ERROR\n"); }
-	// Print if in verbose mode.
-	if (verbose) {
-		printf("number of rows %d\n", bounds->num_rows);
-		printf("number of columns %d\n", bounds->num_cols);
-		printf("number of iterations %d\n", bounds->iterations);
-		printf("number of initial pairs %d\n", bounds->init_pairs);
+	*colon = '\0';
+	*port = colon + 1;
+	return host;
+}
+
+/**
+ *
+ * rankConnect
+ *
+ * Connects this rank to the ones above and below it: it connects to the
+ * next rank, which wraps around to rank 0, and accepts the previous one.
+ * Every rank connects before it accepts, and the listening sockets are
+ * already open, so no rank waits on another that is waiting too.
+ *
+ * @param ranks; the ranks; up and down are set.
+ * @param peers; where every rank listens.
+ * @return void.
+ **/
+void rankConnect(Ranks *ranks, const char *peers) {
+	char *port;
+	char *host;
+	if (ranks->listenfd < 0) {
+		host = peerAddress(peers, ranks->rank, &port);
+		ranks->listenfd = open_listenfd(port);
+		if (ranks->listenfd < 0) {
+			printf("ERROR: rank %d could not listen on port %s\n", ranks->rank, port);
+			exit(1);
+		}
+		free(host);
 	}
-	// Initialize the values to be read.
-	int col = 0;
-	int row = 0;
-	int index = 0;
-	// Allocate memory for the game board.
-	char *earth = malloc(bounds->num_rows * bounds->num_cols * sizeof(int));
-	if (earth == NULL) {
-		printf("ERROR: memory allocation failed\n");
+
+	int next = (ranks->rank + 1) % ranks->num_ranks;
+	host = peerAddress(peers, next, &port);
+	for (int tries = 0; tries < CONNECT_TRIES; ++tries) {
+		ranks->down = open_clientfd(host, port);
+		if (ranks->down >= 0) { break; }
+		usleep(100000);
+	}
+	if (ranks->down < 0) {
+		printf("ERROR: rank %d could not reach rank %d at %s:%s\n", ranks->rank, next, host, port);
 		exit(1);
 	}
-	// Initialize each cell as dead.	
-	for (int i = 0; i < bounds->num_rows * bounds->num_cols; ++i){
-		earth[i] = '-';
+	free(host);
+	sendAll(ranks->down, &ranks->rank, sizeof(int));
+
+	int prev = (ranks->rank + ranks->num_ranks - 1) % ranks->num_ranks;
+	int from = -1;
+	ranks->up = accept(ranks->listenfd, NULL, NULL);
+	if (ranks->up >= 0) { recvAll(ranks->up, &from, sizeof(int)); }
+	if (from != prev) {
+		printf("ERROR: rank %d expected rank %d to connect\n", ranks->rank, prev);
+		exit(1);
 	}
-	// Read the cells that start alive.
-	ret = fscanf(init_state, "%d %d", &col, &row);
-	while (ret == 2 && ret != EOF) {
-		// Convert to 1D array and set to alive.
-		index = (bounds->num_cols * row) + col;
-		earth[index] = '@';
-		ret = fscanf(init_state, "%d %d", &col, &row);
-	}
-	// Close the file and return the pointer to the game board.
-	fclose(init_state);
-	return earth;
+	close(ranks->listenfd);
+	ranks->listenfd = -1;
+
+	// The halos are small and every rank waits for them.
+	int optval = 1;
+	setsockopt(ranks->up, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(int));
+	setsockopt(ranks->down, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(int));
+}
+
+/**
+ * Sets row_start..row_end (inclusive) to the rows rank owns, spreading the
+ * remainder over the first ranks.
+ **/
+void rankRows(int num_rows, int num_ranks, int rank, int *row_start, int *row_end) {
+	int rows = num_rows / num_ranks;
+	int extra = num_rows % num_ranks;
+	*row_start = rank * rows + (rank < extra ? rank : extra);
+	*row_end = *row_start + rows + (rank < extra) - 1;
 }
 
 /**
  *
- * printEarth
+ * runRanks
  *
- * Print's the board out as a N x N torus
+ * Runs this process's rank of a distributed run. The rank keeps its band
+ * with halo rows of the bands on either side in a board of its own, which
+ * it runs through runLife like any other board, once: the threads stop
+ * every halo generations while thread 0 trades rows with the neighbors.
+ * The halo rows wrap around that board wrongly, but the error only creeps
+ * in a row per generation, so the band itself is right when the
+ * neighbors' rows are traded in again. At the end the bands are collected
+ * into rank 0's board.
  *
- * @param earth; a pointer to the game board. 
- * @param bounds; a pointer to an init_data struct holding the config file
- * 			specifications.
- * @return void. 
+ * @param earth; the whole board; on rank 0, the final generation after.
+ * @param bounds; the board's size, iterations and rule.
+ * @param options; how each rank runs its band.
+ * @param ranks; the ranks, with this process's rank set.
+ * @param peers; where every rank listens.
+ * @param elapsed; set to how long rank 0 took, not counting the collection.
+ * @return void.
  **/
-void printEarth(char *earth, init_data bounds, int iteration) {
-	// Local variables
-	int i = 0;
-	int j = 0;
-	int index = 0;
-	printf("DAY %d\n==================\n", iteration + 1);
-	// Print variables out row by row.
-	for (i = 0; i < bounds.num_rows; ++i) {
-		// Print out each element in the curent column.
-		for (j = 0; j < bounds.num_cols; ++j) {
-			// Convert to 1D and print out the current element.
-			index = (bounds.num_cols * i) + j;
-			printf("%c ", earth[index]);
-		}
-		// Print next row underneath previous row.
-		printf("\n");
+void runRanks(Board *earth, init_data *bounds, Options options, Ranks *ranks,
+		const char *peers, struct timeval *elapsed) {
+	int halo = ranks->halo;
+	int row_start, row_end;
+	rankRows(bounds->num_rows, ranks->num_ranks, ranks->rank, &row_start, &row_end);
+	int own_rows = row_end - row_start + 1;
+
+	// The band starts out with the rows around it already in place.
+	init_data local_bounds = *bounds;
+	local_bounds.num_rows = own_rows + 2 * halo;
+	Board *local = boardAlloc(local_bounds.num_rows, bounds->num_cols);
+	size_t row_bytes = local->row_pitch * sizeof(uint64_t);
+	for (int row = 0; row < local_bounds.num_rows; ++row) {
+		int src = (row_start - halo + row + bounds->num_rows) % bounds->num_rows;
+		memcpy(cellWord(local, row, -1), cellWord(earth, src, -1), row_bytes);
 	}
-	usleep(DELAY);
+	refreshHalo(local, 0, local->num_rows - 1);
+	const char *error = checkOptions(&options, local_bounds.num_rows, bounds->num_cols);
+	if (error != NULL) {
+		printf("ERROR: %s\n", error);
+		exit(1);
+	}
+	int p_flag = options.p_flag;
+	options.p_flag = 0;
+
+	rankConnect(ranks, peers);
+	ranks->own_rows = own_rows;
+	runLife(local, &local_bounds, options, elapsed, ranks);
+	ranks->step_usec = elapsed->tv_sec * 1000000LL + elapsed->tv_usec - ranks->exchange_usec;
+
+	// Put the band in its place in the whole board and pass it on.
+	for (int row = 0; row < own_rows; ++row) {
+		memcpy(cellWord(earth, row_start + row, -1), cellWord(local, halo + row, -1), row_bytes);
+	}
+	gatherBands(ranks, earth, row_start, row_end);
+	if (p_flag) {
+		printf("Rank %d:\t %d:%d\t(%d)\tstep %lld.%06lld s\texchange %lld.%06lld s\n",
+				ranks->rank, row_start, row_end, own_rows,
+				ranks->step_usec / 1000000, ranks->step_usec % 1000000,
+				ranks->exchange_usec / 1000000, ranks->exchange_usec % 1000000);
+	}
+	close(ranks->up);
+	close(ranks->down);
+	boardFree(local);
 }
 
 /**
  *
- * simulateLife
+ * exchangeHalo
  *
- * Simulates Conway's game of life for one iteration; determine's which cells
- * live or die based on # of neighbors, saving these cells to an array, and
- * then changing the cells in the array after checking the entire board. 
+ * Sends the first and last halo rows of this rank's band to the ranks
+ * above and below it, and puts theirs in the halo rows on either side. All
+ * four transfers go on at once, so two ranks that send each other more
+ * than a socket holds don't both wait for the other to read.
  *
- * @param thread_data; a pointer to a struct holding all the necessary data. 
- * @return void. 
+ * @param ranks; the ranks.
+ * @param local; the band with its halo rows.
+ * @param own_rows; the number of rows in the band itself.
+ * @return void.
  **/
-void simulateLife(Threads *thread_data){
-
-	// Start and end INDEXES (calculated by each threads row_start and row_end
-	int start = thread_data->row_start * thread_data->bounds->num_cols;
-	int end = (thread_data->row_end * thread_data->bounds->num_cols)
-	   	+ thread_data->bounds->num_cols - 1;
-	
-	// Use an integer array (initialized to 0) to determine which cells
-	// to kill or resurrect. change is same size as earth.
-	int *change = calloc(thread_data->bounds->num_rows * thread_data->bounds->num_cols, sizeof(int));
-	
-	// Walk through the entire earth array.	
-	pthread_barrier_wait(thread_data->BARRIER);
-	for (int i = start; i < end + 1; i++) {	
-		
-		// If alive; check neigbors
-		if (thread_data->earth[i] == '@') {
-			
-			// If alive and >= 1 neighbors; KILL
-			if (neighbors(thread_data->earth, i, *(thread_data->bounds)) <= 1) {
-				change[i] = -1;
+void exchangeHalo(Ranks *ranks, Board *local, int own_rows) {
+	struct timeval start, end, diff;
+	gettimeofday(&start, NULL);
+	int halo = ranks->halo;
+	size_t bytes = (size_t)halo * local->row_pitch * sizeof(uint64_t);
+	int fds[2] = { ranks->up, ranks->down };
+	const char *out[2] = { (char *)cellWord(local, halo, -1), (char *)cellWord(local, own_rows, -1) };
+	char *in[2] = { (char *)cellWord(local, 0, -1), (char *)cellWord(local, own_rows + halo, -1) };
+	size_t sent[2] = { 0, 0 };
+	size_t received[2] = { 0, 0 };
+	while (sent[0] < bytes || sent[1] < bytes || received[0] < bytes || received[1] < bytes) {
+		struct pollfd polls[2];
+		for (int side = 0; side < 2; ++side) {
+			polls[side].fd = fds[side];
+			polls[side].events = (sent[side] < bytes ? POLLOUT : 0)
+				| (received[side] < bytes ? POLLIN : 0);
+			polls[side].revents = 0;
+		}
+		if (poll(polls, 2, -1) < 0 && errno != EINTR) {
+			printf("ERROR: rank %d could not wait for its neighbors\n", ranks->rank);
+			exit(1);
+		}
+		for (int side = 0; side < 2; ++side) {
+			int lost = 0;
+			if (polls[side].revents & POLLOUT) {
+				ssize_t n = send(fds[side], out[side] + sent[side], bytes - sent[side],
+						MSG_DONTWAIT | MSG_NOSIGNAL);
+				if (n > 0) { sent[side] += n; }
+				else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) { lost = 1; }
 			}
-			// If alive and >= 4 neighbors; KILL
-			else if (neighbors(thread_data->earth, i, *(thread_data->bounds)) >= 4) {
-				change[i] = -1;
+			if (polls[side].revents & (POLLIN | POLLHUP | POLLERR)) {
+				ssize_t n = recv(fds[side], in[side] + received[side], bytes - received[side],
+						MSG_DONTWAIT);
+				if (n > 0) { received[side] += n; }
+				else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+					lost = 1;
+				}
 			}
-		}
-		
-		// If dead with 3 neighbors; RESURRECT
-		if (thread_data->earth[i] == '-') {
-			if(neighbors(thread_data->earth, i, *(thread_data->bounds)) == 3) {
-				change[i] = -2;
+			if (lost) {
+				printf("ERROR: rank %d lost a neighbor\n", ranks->rank);
+				exit(1);
 			}
 		}
 	}
-	
-	// change the indexes that are need to be changed
-	pthread_barrier_wait(thread_data->BARRIER);
-	for (int j = start; j < end + 1; ++j) {
-		
-		// -1 means that we kill the cell.
-		if (change[j] == -1) {
-			thread_data->earth[j] = '-';
-		}
-		
-		// -2 means that we resurrect the cell.
-		else if (change[j] == -2) {
-			thread_data->earth[j] = '@';
-		}
-	}
-	
-	// Free the memory before next call to simulateLife.
-	pthread_barrier_wait(thread_data->BARRIER);
-	free(change);
+	refreshHalo(local, 0, local->num_rows - 1);
+	gettimeofday(&end, NULL);
+	timeDiff(&diff, &start, &end);
+	ranks->exchange_usec += diff.tv_sec * 1000000LL + diff.tv_usec;
+}
+
+/**
+ * Returns the generation a thread steps up to before stopping: the end of
+ * the run, or in a distributed run, the next whole number of halo
+ * generations if that comes first.
+ **/
+long long rankStop(const Threads *thread_data, long long generation, long long end) {
+	if (thread_data->ranks == NULL) { return end; }
+	int halo = thread_data->ranks->halo;
+	long long stop = (generation / halo + 1) * halo;
+	return stop < end ? stop : end;
 }
 
 /**
  *
- * neighbors
+ * rankExchange
  *
- * Determine's the number of live neighbors a cell has by accessing the board
- * as torus. 
+ * Trades halo rows with the neighboring ranks in the middle of a run, on
+ * thread 0, while the other threads wait at a barrier on either side.
+ * The column-sum engine's rows are packed into the board to be sent and
+ * unpacked from it once received, and the tiles over the received rows
+ * are stamped as changed so the next generation computes them.
  *
- * @param earth; a pointer to the game board. 
- * @param index; the specific index that we are inspecting for neighbors.
- * @param bounds; a pointer to an init_data struct holding the config file
- * 			specifications.
- * @return neighbors; the number of surrounding live cells. 
+ * @param thread_data; the thread, with the current generation in earth.
+ * @param generation; the number of generations simulated so far.
+ * @return void.
  **/
-int neighbors(char *earth, int index, init_data bounds) {
-	// To access the cells, declare lots of variables for simplicity.
-	int neighbors = 0;
-	int col = (index % bounds.num_cols);
-	int row = (index / bounds.num_cols);
-	// Use the column and row to determine the cells to check for neighbors.
-	// Determine the cells if the board is a torus.
-	// Upper, lower, left, and right cells:
-	int r_index = (row * bounds.num_cols) + ((col + 1) % bounds.num_cols);
-	int l_index = (row * bounds.num_cols) + (((col - 1) + bounds.num_cols) % bounds.num_cols);
-	int lower = (((row + 1) % bounds.num_rows) * bounds.num_cols) + col;
-	int upper = ((((row - 1) + bounds.num_rows) % bounds.num_rows) * bounds.num_cols) + col; 
-	// Split the next variables into two calculations due to length.
-	// Use '%' operator to have the index warp around like a torus.
-	// Right lower index:
-	int r_lower = (lower / bounds.num_cols) * bounds.num_cols;
-	r_lower += ((lower % bounds.num_cols) + 1) % bounds.num_cols;
-	// Left lower index:
-	int l_lower = (lower / bounds.num_cols) * bounds.num_cols;
-	l_lower += ((lower % bounds.num_cols) - 1 + bounds.num_cols) % bounds.num_cols;
-	// Right upper index:
-	int r_upper = (upper / bounds.num_cols) * bounds.num_cols;
-	r_upper += ((upper % bounds.num_cols) + 1) % bounds.num_cols;
-	// Left upper index:
-	int l_upper = (upper / bounds.num_cols) * bounds.num_cols;
-	l_upper += ((upper % bounds.num_cols) - 1 + bounds.num_cols) % bounds.num_cols;
-	// If there is a live cell at any ofthese indices; increment neighbors.
-	// Check left and right of index for neighbors.
-	if (earth[l_index] == '@') { neighbors += 1;	}
-	if (earth[r_index] == '@') { neighbors += 1;	}
-	// Check upper 3 cells for neighbors.
-	if (earth[upper] == '@') { neighbors += 1;	}
-	if (earth[l_upper] == '@') { neighbors += 1;	}
-	if (earth[r_upper] == '@') { neighbors += 1;	}
-	// Check lower 3 cells for neighbors.
-	if (earth[lower] == '@') { neighbors += 1;	}
-	if (earth[l_lower] == '@') { neighbors += 1;	}
-	if (earth[r_lower] == '@') { neighbors += 1;	}
-	// Return the total number of neighbors.
-	return neighbors;
+void rankExchange(Threads *thread_data, long long generation) {
+	barrierWait(thread_data);
+	if (thread_data->tid == 0) {
+		Ranks *ranks = thread_data->ranks;
+		Board *earth = thread_data->earth;
+		ByteBoard *bytes = thread_data->bytes;
+		int halo = ranks->halo;
+		int own_rows = ranks->own_rows;
+		int below = own_rows + halo;
+		if (bytes != NULL) {
+			packBoard(bytes, earth, halo, 2 * halo - 1);
+			packBoard(bytes, earth, own_rows, below - 1);
+		}
+		exchangeHalo(ranks, earth, own_rows);
+		if (bytes != NULL) {
+			unpackBoard(earth, bytes, 0, halo - 1);
+			unpackBoard(earth, bytes, below, earth->num_rows - 1);
+			refreshByteHalo(bytes, 0, halo - 1);
+			refreshByteHalo(bytes, below, earth->num_rows - 1);
+		}
+		Tiles *tiles = thread_data->tiles;
+		if (tiles != NULL) {
+			for (int tile_row = 0; tile_row < tiles->tiles_down; ++tile_row) {
+				int first = tile_row * tiles->tile_rows;
+				int last = first + tiles->tile_rows - 1;
+				if (first >= halo && last < below) { continue; }
+				for (int tile_col = 0; tile_col < tiles->tiles_across; ++tile_col) {
+					atomic_store_explicit(&tiles->changed[(size_t)tile_row * tiles->tiles_across
+							+ tile_col], generation, memory_order_relaxed);
+				}
+			}
+		}
+		// A new round of the wavefront.
+		if (thread_data->wavefront != NULL) { atomic_store(&thread_data->wavefront->finished, 0); }
+	}
+	barrierWait(thread_data);
 }
 
 /**
  *
- * timeDiff
+ * gatherBands
  *
- * Calculates the elapsed time of between the call to gettimeofday for the
- * beginning and end of the simulation 
+ * Collects the final bands into rank 0's board. Each rank gets the rows of
+ * every rank after it from the one below, and sends them on, after its own,
+ * to the one above.
  *
- * @param result; the timeval struct to save the resulting difference in. 
- * @param start; the timeval struct storing the starting time.
- * @param end; the timeval struct storing the ending time. 
- * @return void. 
+ * @param ranks; the ranks.
+ * @param earth; the whole board, with this rank's band in place.
+ * @param row_start; the first row of this rank's band.
+ * @param row_end; the last row of this rank's band (inclusive).
+ * @return void.
  **/
-void timeDiff (struct timeval *result, struct timeval *start, struct timeval *end){
-	// Preform the carry operations.
-	if (end->tv_usec < start->tv_usec) {
-		int nsec = (start->tv_usec - end->tv_usec) / 1000000 + 1;
-		start->tv_usec -= 1000000 * nsec;
-		start->tv_usec += nsec;
+void gatherBands(Ranks *ranks, Board *earth, int row_start, int row_end) {
+	size_t row_bytes = earth->row_pitch * sizeof(uint64_t);
+	if (ranks->rank < ranks->num_ranks - 1) {
+		recvAll(ranks->down, cellWord(earth, row_end + 1, -1),
+				(earth->num_rows - row_end - 1) * row_bytes);
 	}
-	if (end->tv_usec - start->tv_usec > 1000000) {
-		int nsec = (end->tv_usec - start->tv_usec) / 1000000;
-		start->tv_usec += 1000000 * nsec;
-		start->tv_usec -= nsec;
+	if (ranks->rank > 0) {
+		sendAll(ranks->up, cellWord(earth, row_start, -1),
+				(earth->num_rows - row_start) * row_bytes);
+	}
+	else {
+		refreshHalo(earth, 0, earth->num_rows - 1);
+	}
+}
+
+/**
+ * Sends all of buf over fd, giving up on the run if the other end is gone.
+ **/
+void sendAll(int fd, const void *buf, size_t bytes) {
+	for (size_t sent = 0; sent < bytes; ) {
+		ssize_t n = send(fd, (const char *)buf + sent, bytes - sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) { continue; }
+		if (n <= 0) {
+			printf("ERROR: lost a neighbor\n");
+			exit(1);
+		}
+		sent += n;
+	}
+}
+
+/**
+ * Fills buf from fd, giving up on the run if the other end is gone.
+ **/
+void recvAll(int fd, void *buf, size_t bytes) {
+	for (size_t received = 0; received < bytes; ) {
+		ssize_t n = recv(fd, (char *)buf + received, bytes - received, 0);
+		if (n < 0 && errno == EINTR) { continue; }
+		if (n <= 0) {
+			printf("ERROR: lost a neighbor\n");
+			exit(1);
+		}
+		received += n;
 	}
-	// Compute the differences.
-	result->tv_sec = end->tv_sec - start->tv_sec;
-	result->tv_usec = end->tv_usec - start->tv_usec;
 }
 
 /**
@@ -568,7 +6969,9 @@ int open_clientfd(char *hostname, char *port) {
 	hints.ai_flags = AI_NUMERICSERV;
 	hints.ai_flags |= AI_ADDRCONFIG;
 	// Get the desired address info.
-	getaddrinfo(hostname, port, &hints, &listp);
+	if (getaddrinfo(hostname, port, &hints, &listp) != 0) {
+		return -1;
+	}
 	
 	// Check each possible connection.
 	for (p = listp; p; p = p->ai_next) {
@@ -597,6 +7000,51 @@ int open_clientfd(char *hostname, char *port) {
 	}
 }
 
+/**
+ *
+ * open_listenfd
+ *
+ * Opens a socket listening on the specified port, on every address of this
+ * host.
+ *
+ * @param port; the port to listen on, or "0" for any free one.
+ * @return listenfd; the listening socket, or -1 if there is none.
+ **/
+int open_listenfd(char *port) {
+	int listenfd = -1;
+	int optval = 1;
+	struct addrinfo hints, *listp, *p;
+
+	// Set up the structs to be used.
+	memset(&hints, 0, sizeof(struct addrinfo));
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE | AI_ADDRCONFIG | AI_NUMERICSERV;
+	if (getaddrinfo(NULL, port, &hints, &listp) != 0) {
+		return -1;
+	}
+
+	// Bind to the first address that will have us.
+	for (p = listp; p; p = p->ai_next) {
+		if ((listenfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol)) < 0) {
+			continue;
+		}
+		setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(int));
+		if (bind(listenfd, p->ai_addr, p->ai_addrlen) == 0) {
+			break;
+		}
+		close(listenfd);
+	}
+	freeaddrinfo(listp);
+	if (!p) {
+		return -1;
+	}
+	if (listen(listenfd, LISTENQ) < 0) {
+		close(listenfd);
+		return -1;
+	}
+	return listenfd;
+}
+
 /**
  *
  * listRemoteFiles